@@ -6,6 +6,7 @@
 #define SEPI_PLATFORM_IMPLEMENTATION
 #define SEPI_STRING_IMPLEMENTATION
 #define SEPI_ARENA_IMPLEMENTATION
+#define SEPI_HASH_IMPLEMENTATION
 #define SEPI_HASHMAP_IMPLEMENTATION
 
 #include "deps/sepi/hashmap.h"
@@ -49,6 +50,28 @@ main(void) {
     printf("%5s:  %d\n", kv->k_str.cstr, kv->v_u32);
   }
 
+  printf("-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-\n");
+
+  CStr words[] = {"sepi", "amin", "sepi", "mooa", "sepi", "amin"};
+  HashMap* counts = hashmap_init(a, 64);
+  for (U64 i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    *hashmap_get_or_insert_u32(a, counts, str8(words[i])) += 1;
+  }
+  hashmap_upsert_u32(a, counts, str8("mooa"), 10);
+
+  keys = hashmap_keys(a, counts);
+  for (U64 i = 0; i < counts->count; i++) {
+    HashMapKV* kv = hashmap_find(counts, keys[i]);
+    printf("%5s:  %d\n", kv->k_str.cstr, kv->v_u32);
+  }
+
+  printf("-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-\n");
+
+  HashMapStats st = hashmap_stats(hm);
+  printf("load: %.3f  max chain: %lu  empty: %.3f  free: %lu  bytes: %lu\n",
+         st.load_factor, (unsigned long)st.max_chain, st.empty_bucket_ratio,
+         (unsigned long)st.free_list_length, (unsigned long)st.estimated_bytes);
+
   hashmap_purge(hm);
   arena_release(a);
   return 0;
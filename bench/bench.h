@@ -0,0 +1,237 @@
+#ifndef SEPI_BENCH_H
+#define SEPI_BENCH_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "../deps/sepi/base.h"
+#include "../deps/sepi/string.h"
+#include "../deps/sepi/arena.h"
+
+#if defined(OS_LINUX)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* OS_LINUX */
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#define BENCH_KEY_ALPHABET \
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+typedef struct Bench Bench;
+struct Bench {
+  Arena* arena;
+  FILE* csv;
+  U64 max_keys;
+  Bool quick;
+  I32 perf_fd;
+  U64 rng;
+  U64 started_ns;
+  U64 started_misses;
+  volatile U64 sink;
+};
+
+typedef struct BenchResult BenchResult;
+struct BenchResult {
+  CStr suite;
+  CStr structure;
+  CStr op;
+  CStr variant;
+  U64 key_size;
+  U64 map_size;
+  U64 ops;
+  U64 bytes;
+};
+
+typedef struct BenchKeys BenchKeys;
+struct BenchKeys {
+  Str8* keys;
+  U64 count;
+  U64 size;
+};
+
+typedef Nothing (*BenchSuiteFn)(Bench* b);
+
+typedef struct BenchSuite BenchSuite;
+struct BenchSuite {
+  CStr name;
+  BenchSuiteFn run;
+};
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+internal U64 bench_sizes[] = {
+  Thousand(1), Thousand(10), Thousand(100),
+  Million(1), Million(10), Million(100),
+};
+
+internal U64 bench_key_sizes[] = {4, 8, 16, 32, 64, 128, 256, 1024};
+
+internal U64
+bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (U64)ts.tv_sec * Billion(1ull) + (U64)ts.tv_nsec;
+}
+
+internal U64
+bench_rand(Bench* b) {
+  U64 z = (b->rng += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+internal Nothing
+bench_perf_open(Bench* b) {
+  b->perf_fd = -1;
+#if defined(OS_LINUX)
+  struct perf_event_attr pe;
+  MemZeroStruct(&pe);
+  pe.type = PERF_TYPE_HARDWARE;
+  pe.size = sizeof(pe);
+  pe.config = PERF_COUNT_HW_CACHE_MISSES;
+  pe.disabled = 1;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv = 1;
+  b->perf_fd = (I32)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+#endif /* OS_LINUX */
+}
+
+internal U64
+bench_perf_read(Bench* b) {
+  U64 value = 0;
+#if defined(OS_LINUX)
+  if(b->perf_fd >= 0 && read(b->perf_fd, &value, sizeof(value)) != sizeof(value)) {
+    value = 0;
+  }
+#endif /* OS_LINUX */
+  return value;
+}
+
+internal Nothing
+bench_begin(Bench* b) {
+#if defined(OS_LINUX)
+  if(b->perf_fd >= 0) {
+    ioctl(b->perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif /* OS_LINUX */
+  b->started_misses = bench_perf_read(b);
+  b->started_ns = bench_now_ns();
+}
+
+internal Nothing
+bench_end(Bench* b, BenchResult r) {
+  U64 elapsed = bench_now_ns() - b->started_ns;
+  U64 misses = bench_perf_read(b) - b->started_misses;
+#if defined(OS_LINUX)
+  if(b->perf_fd >= 0) {
+    ioctl(b->perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+#endif /* OS_LINUX */
+
+  F64 ops = (F64)Max(r.ops, 1);
+  F64 ns_per_op = (F64)elapsed / ops;
+  F64 misses_per_op = (F64)misses / ops;
+  F64 gb_per_s = r.bytes ? (F64)r.bytes / (F64)Max(elapsed, 1) : 0.0;
+
+  printf("%-8s %-18s %-10s %-16s %6lu %10lu %10.2f ns/op",
+         r.suite, r.structure, r.op, r.variant ? r.variant : "-",
+         (unsigned long)r.key_size, (unsigned long)r.map_size, ns_per_op);
+  if(b->perf_fd >= 0) {
+    printf(" %8.3f miss/op", misses_per_op);
+  }
+  if(r.bytes) {
+    printf(" %8.3f GB/s", gb_per_s);
+  }
+  printf("\n");
+
+  if(b->csv) {
+    fprintf(b->csv, "%s,%s,%s,%s,%lu,%lu,%lu,%.3f,", r.suite, r.structure,
+            r.op, r.variant ? r.variant : "", (unsigned long)r.key_size,
+            (unsigned long)r.map_size, (unsigned long)r.ops, ns_per_op);
+    if(b->perf_fd >= 0) {
+      fprintf(b->csv, "%.4f", misses_per_op);
+    }
+    fprintf(b->csv, ",%.4f\n", gb_per_s);
+    fflush(b->csv);
+  }
+}
+
+internal Nothing
+bench_csv_header(Bench* b) {
+  if(b->csv) {
+    fprintf(b->csv, "suite,structure,op,variant,key_size,map_size,ops,"
+            "ns_per_op,cache_misses_per_op,gb_per_s\n");
+  }
+}
+
+/* keys are printable, unique within `count` starting at `first` and
+   NUL-terminated so they can also feed the stb_ds string maps */
+internal BenchKeys
+bench_keys(Bench* b, U64 first, U64 count, U64 size) {
+  BenchKeys k = {0};
+  k.count = count;
+  k.size = size;
+  k.keys = arena_push_array_no_zero(b->arena, Str8, count);
+  U8* data = arena_push_array_no_zero(b->arena, U8, count * (size + 1));
+
+  for(U64 i = 0; i < count; ++i) {
+    U8* key = data + i * (size + 1);
+    U64 id = first + i;
+    U64 at = 0;
+    for(; at < Min(size, 11); ++at, id >>= 6) {
+      key[at] = BENCH_KEY_ALPHABET[id & 63];
+    }
+    for(U64 r = 0; at < size; ++at) {
+      if((at & 7) == 0 || r == 0) {
+        r = bench_rand(b);
+      }
+      key[at] = BENCH_KEY_ALPHABET[r & 63];
+      r >>= 6;
+    }
+    key[size] = 0;
+    k.keys[i] = str8_raw(key, size);
+  }
+  return k;
+}
+
+internal Bool
+bench_keys_fit(U64 count, U64 size) {
+  return size >= 8 || (count * 2) <= ((U64)1 << (6 * size));
+}
+
+internal U64*
+bench_shuffle(Bench* b, U64 count) {
+  U64* order = arena_push_array_no_zero(b->arena, U64, count);
+  for(U64 i = 0; i < count; ++i) {
+    order[i] = i;
+  }
+  for(U64 i = count; i > 1; --i) {
+    U64 j = bench_rand(b) % i;
+    U64 t = order[i - 1];
+    order[i - 1] = order[j];
+    order[j] = t;
+  }
+  return order;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_BENCH_H */
@@ -0,0 +1,128 @@
+/* ===================================================== */
+/*                      CACHE SUITE                      */
+/* ===================================================== */
+
+internal CStr bench_cache_policies[] = {"lru", "clock"};
+
+internal Nothing
+bench_cache_policy(Bench* b, BenchKeys* keys, U64* order, CachePolicy policy) {
+  U64 n = keys->count;
+  U64 capacity = Max(n / 4, 1);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"cache", bench_cache_policies[policy], "put", 0, keys->size,
+                   capacity, n, 0};
+  Cache* c = cache_init(b->arena, .max_entries = capacity, .policy = policy);
+  U64 sum = 0;
+
+  r.variant = "churn";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += cache_put_u64(c, keys->keys[i], i, 0) != 0;
+  }
+  bench_end(b, r);
+  AssertAlways(sum == n && c->count == capacity);
+  AssertAlways(c->evictions == n - capacity);
+
+  r.op = "get";
+  r.variant = "shuffled";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    HashMapKV* kv = cache_get(c, keys->keys[order[i]]);
+    sum += kv ? kv->v_u64 : 0;
+  }
+  bench_end(b, r);
+
+  r.op = "get-or-put";
+  r.variant = "shuffled";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    Str8 key = keys->keys[order[i]];
+    HashMapKV* kv = cache_get(c, key);
+    sum += kv ? kv->v_u64 : cache_put_u64(c, key, order[i], 0)->v_u64;
+  }
+  bench_end(b, r);
+  AssertAlways(c->count == capacity && c->hits + c->misses == 2 * n);
+
+  r.op = "remove";
+  r.variant = 0;
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += cache_remove(c, keys->keys[i], 0);
+  }
+  bench_end(b, r);
+  AssertAlways(c->count == 0 && c->bytes == 0 && c->ring == 0);
+
+  b->sink += sum;
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_cache_limits(Bench* b) {
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  Cache* c = cache_init(b->arena, .max_bytes = 100, .max_key_size = 300);
+  U8 long_key[301] = {0};
+
+  AssertAlways(cache_put_u64(c, str8("a"), 1, 40) != 0);
+  AssertAlways(cache_put_u64(c, str8("b"), 2, 40) != 0);
+  AssertAlways(cache_put_u64(c, str8("c"), 3, 100) == 0);
+  AssertAlways(cache_put_u64(c, str8("a"), 4, 100) == 0);
+  AssertAlways(cache_put_u64(c, str8_raw(long_key, 301), 5, 0) == 0);
+  AssertAlways(c->count == 2 && c->bytes == 82 && c->evictions == 0);
+  AssertAlways(cache_get(c, str8("a"))->v_u64 == 1);
+
+  AssertAlways(cache_put_u64(c, str8_raw(long_key, 300), 6, 0) == 0);
+  AssertAlways(cache_put_u64(c, str8_raw(long_key, 90), 7, 0) != 0);
+  AssertAlways(c->count == 1 && c->bytes == 90 && c->evictions == 2);
+  AssertAlways(cache_get(c, str8_raw(long_key, 90))->v_u64 == 7);
+  AssertAlways(cache_put_u64(c, str8(""), 8, 0) != 0);
+  AssertAlways(cache_get(c, str8(""))->v_u64 == 8);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_cache_sharded(Bench* b, BenchKeys* keys, U64* order) {
+  U64 n = keys->count;
+  CacheSharded* cs = cache_sharded_init(b->arena, 8, .max_entries = n);
+  BenchResult r = {"cache", "sharded", "put", "shards=8", keys->size, n, n, 0};
+  HashMapKV out = {0};
+  U64 sum = 0;
+
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += cache_sharded_put(cs, keys->keys[i], (HashMapKV){.v_u64 = i}, 0);
+  }
+  bench_end(b, r);
+
+  r.op = "get";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    if(cache_sharded_get(cs, keys->keys[order[i]], &out)) {
+      sum += out.v_u64;
+    }
+  }
+  bench_end(b, r);
+
+  b->sink += sum;
+  cache_sharded_release(cs);
+}
+
+internal Nothing
+bench_cache(Bench* b) {
+  bench_cache_limits(b);
+  for(U64 si = 0; si < ArrayCount(bench_sizes); ++si) {
+    U64 n = bench_sizes[si];
+    if(n > b->max_keys) {
+      break;
+    }
+
+    for(U64 ki = 0; ki < 2; ++ki) {
+      ArenaScratch s = arena_scratch_begin(b->arena);
+      BenchKeys keys = bench_keys(b, 0, n, ki ? 64 : 16);
+      U64* order = bench_shuffle(b, n);
+      bench_cache_policy(b, &keys, order, CachePolicy_LRU);
+      bench_cache_policy(b, &keys, order, CachePolicy_Clock);
+      bench_cache_sharded(b, &keys, order);
+      arena_scratch_end(s);
+    }
+  }
+}
@@ -0,0 +1,186 @@
+/* ===================================================== */
+/*                       CSV SUITE                       */
+/* ===================================================== */
+
+#define BENCH_CSV_MAX_FIELDS 64
+
+typedef struct BenchCsvCount BenchCsvCount;
+struct BenchCsvCount {
+  U64 rows;
+  U64 fields;
+  U64 bytes;
+};
+
+/* quoted csv has descriptions holding commas, doubled quotes and line
+   breaks; tsv is the same records with nothing to quote */
+internal Str8
+bench_csv_text(Bench* b, U8 delimiter, Bool quotes, U64 size) {
+  U8* text = arena_push_array_no_zero(b->arena, U8, size);
+  U64 at = 0;
+  while(at + 512 < size) {
+    U64 value = bench_rand(b);
+    at += (U64)sprintf((char*)text + at, "%llu%c%s%c%.3f%c",
+                       (unsigned long long)(value >> 44), delimiter,
+                       bench_string_segments[value % ArrayCount(bench_string_segments)],
+                       delimiter, (F64)(value & 0xFFFFF) / 977.0, delimiter);
+    if(quotes) {
+      text[at++] = '"';
+    }
+    U64 words = 2 + bench_rand(b) % 10;
+    for(U64 w = 0; w < words; ++w) {
+      CStr segment = bench_string_segments[bench_rand(b) %
+                                           ArrayCount(bench_string_segments)];
+      U64 pick = bench_rand(b) % 16;
+      CStr gap = !quotes || pick > 2 ? " " : pick == 0 ? ", " : pick == 1 ? "\"\"" : "\n";
+      at += (U64)sprintf((char*)text + at, "%s%s", segment, gap);
+    }
+    if(quotes) {
+      text[at++] = '"';
+    }
+    at += (U64)sprintf((char*)text + at, "%c2024-%02llu-%02llu%c%s\r\n", delimiter,
+                       (unsigned long long)(1 + value % 12),
+                       (unsigned long long)(1 + value % 28), delimiter,
+                       value & 1 ? "true" : "false");
+  }
+  return str8_raw(text, at);
+}
+
+internal Nothing
+bench_csv_add(BenchCsvCount* c, Str8* fields, U64 count) {
+  c->rows += 1;
+  c->fields += count;
+  for(U64 i = 0; i < count; ++i) {
+    c->bytes += fields[i].size;
+  }
+}
+
+/* the byte at a time loop everyone writes first: fields are copied out
+   with their quotes undone */
+internal Nothing
+bench_csv_scalar(Str8 text, U8 delimiter, Bool quotes, U8* out, BenchCsvCount* c) {
+  const U8* p = (const U8*)text.cstr;
+  U64 size = text.size;
+  U64 at = 0;
+  Str8 fields[BENCH_CSV_MAX_FIELDS];
+  while(at < size) {
+    U64 count = 0;
+    U64 used = 0;
+    Bool row_end = FALSE;
+    while(!row_end) {
+      U8* field = out + used;
+      U64 n = 0;
+      if(quotes && at < size && p[at] == '"') {
+        at += 1;
+        while(at < size && !(p[at] == '"' && (at + 1 >= size || p[at + 1] != '"'))) {
+          at += p[at] == '"';
+          field[n++] = p[at++];
+        }
+        at += 1;
+      }
+      while(at < size && p[at] != delimiter && p[at] != '\n') {
+        field[n++] = p[at++];
+      }
+      row_end = at >= size || p[at] == '\n';
+      at += 1;
+      if(row_end && n && field[n - 1] == '\r') {
+        n -= 1;
+      }
+      fields[count++] = str8_raw(field, n);
+      used += n;
+    }
+    if(count > 1 || fields[0].size) {
+      bench_csv_add(c, fields, count);
+    }
+  }
+}
+
+internal Nothing
+bench_csv_parallel_row(RawPtr user, U32 thread, CsvRow* row) {
+  BenchCsvCount* counts = (BenchCsvCount*)user;
+  bench_csv_add(&counts[thread], row->fields, row->count);
+}
+
+internal Nothing
+bench_csv(Bench* b) {
+  U64 size = b->quick ? MB(8) : MB(128);
+  U64 rounds = b->quick ? 2 : 4;
+  U8 delimiters[] = {',', '\t'};
+  CStr variants[] = {"csv", "tsv"};
+  U32 cores = platform_get_cpu_cores();
+
+  for(U64 vi = 0; vi < ArrayCount(variants); ++vi) {
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    Bool quotes = delimiters[vi] == ',';
+    CsvFlags flags = quotes ? 0 : CsvFlag_NoQuotes;
+    Str8 text = bench_csv_text(b, delimiters[vi], quotes, size);
+    U8* out = arena_push_array_no_zero(b->arena, U8, MB(1));
+    BenchCsvCount want = {0};
+    BenchResult r = {"csv", "scalar", "parse", variants[vi], 0, text.size, rounds,
+                     rounds * text.size
+                    };
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      MemZeroStruct(&want);
+      bench_csv_scalar(text, delimiters[vi], quotes, out, &want);
+    }
+    bench_end(b, r);
+
+    r.structure = "csv_next";
+    r.op = "memory";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      BenchCsvCount got = {0};
+      CsvReader reader = csv_reader_memory(b->arena, text, delimiters[vi], flags);
+      CsvRow row;
+      while(csv_next(&reader, &row)) {
+        bench_csv_add(&got, row.fields, row.count);
+      }
+      AssertAlways(!reader.error && got.rows == want.rows && got.fields == want.fields &&
+                   got.bytes == want.bytes);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+
+    /* the page cache copy through fread is part of what is timed */
+    FILE* file = tmpfile();
+    AssertAlways(file && fwrite(text.cstr, 1, text.size, file) == text.size);
+    r.op = "file";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      BenchCsvCount got = {0};
+      rewind(file);
+      CsvReader reader = csv_reader_file(b->arena, file, delimiters[vi], flags);
+      CsvRow row;
+      while(csv_next(&reader, &row)) {
+        bench_csv_add(&got, row.fields, row.count);
+      }
+      AssertAlways(!reader.error && got.rows == want.rows && got.bytes == want.bytes);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+    fclose(file);
+
+    r.structure = "csv_parallel";
+    r.op = "memory";
+    r.key_size = cores;
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      BenchCsvCount* counts = arena_push_array(b->arena, BenchCsvCount, cores);
+      BenchCsvCount got = {0};
+      AssertAlways(csv_parallel(text, delimiters[vi], flags, cores, bench_csv_parallel_row,
+                                counts) == CsvError_None);
+      for(U32 t = 0; t < cores; ++t) {
+        got.rows += counts[t].rows;
+        got.bytes += counts[t].bytes;
+      }
+      AssertAlways(got.rows == want.rows && got.bytes == want.bytes);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+    b->sink += want.bytes;
+    arena_scratch_end(s);
+  }
+}
@@ -0,0 +1,179 @@
+/* ===================================================== */
+/*                      FILTER SUITE                     */
+/* ===================================================== */
+
+internal U64 bench_filter_bits[] = {8, 10, 12, 16};
+
+internal Nothing
+bench_filter_report_fpr(CStr name, U64 bits, U64 n, U64 positives) {
+  printf("filter   %-18s fpr        bits/key=%-6lu %10lu %10.4f %%\n", name,
+         (unsigned long)bits, (unsigned long)n, 100.0 * (F64)positives / (F64)n);
+}
+
+internal Nothing
+bench_filter_bloom(Bench* b, BenchKeys* hit, BenchKeys* miss, U64* hashes,
+                   U64* miss_hashes) {
+  U64 n = hit->count;
+  for(U64 bi = 0; bi < ArrayCount(bench_filter_bits); ++bi) {
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    U64 bits = bench_filter_bits[bi];
+    char variant[32];
+    snprintf(variant, sizeof(variant), "bits=%lu", (unsigned long)bits);
+    BenchResult r = {"filter", "bloom", 0, variant, hit->size, n, n, 0};
+    BloomFilter* bf = bloom_init(b->arena, n, bits);
+    U64 positives = 0;
+
+    r.op = "add";
+    bench_begin(b);
+    for(U64 i = 0; i < n; ++i) {
+      bloom_add_hash(bf, hashes[i]);
+    }
+    bench_end(b, r);
+
+    r.op = "test-hit";
+    bench_begin(b);
+    for(U64 i = 0; i < n; ++i) {
+      positives += bloom_test_hash(bf, hashes[i]);
+    }
+    bench_end(b, r);
+    AssertAlways(positives == n);
+
+    positives = 0;
+    r.op = "test-miss";
+    bench_begin(b);
+    for(U64 i = 0; i < n; ++i) {
+      positives += bloom_test_hash(bf, miss_hashes[i]);
+    }
+    bench_end(b, r);
+    bench_filter_report_fpr("bloom", bits, n, positives);
+
+    if(b->csv) {
+      fprintf(b->csv, "filter,bloom,fpr,%s,%lu,%lu,%lu,,,%.6f\n", variant,
+              (unsigned long)hit->size, (unsigned long)n, (unsigned long)n,
+              (F64)positives / (F64)n);
+    }
+    arena_scratch_end(s);
+  }
+  Ignore(miss);
+}
+
+internal Nothing
+bench_filter_cuckoo(Bench* b, BenchKeys* hit, U64* hashes, U64* miss_hashes) {
+  U64 n = hit->count;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"filter", "cuckoo", 0, "fp=16", hit->size, n, n, 0};
+  CuckooFilter* cf = cuckoo_init(b->arena, n);
+  U64 positives = 0;
+
+  r.op = "add";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    cuckoo_add_hash(cf, hashes[i]);
+  }
+  bench_end(b, r);
+
+  r.op = "test-hit";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    positives += cuckoo_test_hash(cf, hashes[i]);
+  }
+  bench_end(b, r);
+  AssertAlways(positives == n);
+
+  positives = 0;
+  r.op = "test-miss";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    positives += cuckoo_test_hash(cf, miss_hashes[i]);
+  }
+  bench_end(b, r);
+  bench_filter_report_fpr("cuckoo", 16, n, positives);
+  if(b->csv) {
+    fprintf(b->csv, "filter,cuckoo,fpr,fp=16,%lu,%lu,%lu,,,%.6f\n",
+            (unsigned long)hit->size, (unsigned long)n, (unsigned long)n,
+            (F64)positives / (F64)n);
+  }
+
+  r.op = "remove";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    cuckoo_remove_hash(cf, hashes[i]);
+  }
+  bench_end(b, r);
+  AssertAlways(cf->count == 0);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_filter_hashmap(Bench* b, BenchKeys* hit, BenchKeys* miss, U64* order) {
+  U64 n = hit->count;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"filter", "hashmap", "find-miss", 0, hit->size, n, n, 0};
+  HashMap* hm = hashmap_init(b->arena, n);
+  for(U64 i = 0; i < n; ++i) {
+    hashmap_push_u64(b->arena, hm, hit->keys[i], i);
+  }
+  BloomFilter* bf = bloom_init(b->arena, n, BLOOM_DEFAULT_BITS_PER_KEY);
+  bloom_add_hashmap(bf, hm);
+  CuckooFilter* cf = cuckoo_init(b->arena, n);
+  cuckoo_add_hashmap(cf, hm);
+  U64 sum = 0;
+
+  r.variant = "none";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hashmap_find(hm, miss->keys[order[i]]) != 0;
+  }
+  bench_end(b, r);
+
+  r.variant = "bloom";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += bloom_find(bf, hm, miss->keys[order[i]]) != 0;
+  }
+  bench_end(b, r);
+
+  r.variant = "cuckoo";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += cuckoo_find(cf, hm, miss->keys[order[i]]) != 0;
+  }
+  bench_end(b, r);
+
+  r.op = "find-hit";
+  r.variant = "bloom";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += bloom_find(bf, hm, hit->keys[order[i]])->v_u64;
+  }
+  bench_end(b, r);
+
+  b->sink += sum;
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_filter(Bench* b) {
+  for(U64 si = 0; si < ArrayCount(bench_sizes); ++si) {
+    U64 n = bench_sizes[si];
+    if(n > b->max_keys) {
+      break;
+    }
+
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    BenchKeys hit = bench_keys(b, 0, n, 16);
+    BenchKeys miss = bench_keys(b, n, n, 16);
+    U64* order = bench_shuffle(b, n);
+    U64* hashes = arena_push_array_no_zero(b->arena, U64, n);
+    U64* miss_hashes = arena_push_array_no_zero(b->arena, U64, n);
+    for(U64 i = 0; i < n; ++i) {
+      hashes[i] = hashmap_hasher(hit.keys[i]);
+      miss_hashes[i] = hashmap_hasher(miss.keys[i]);
+    }
+
+    bench_filter_bloom(b, &hit, &miss, hashes, miss_hashes);
+    bench_filter_cuckoo(b, &hit, hashes, miss_hashes);
+    bench_filter_hashmap(b, &hit, &miss, order);
+    arena_scratch_end(s);
+  }
+}
@@ -0,0 +1,121 @@
+/* ===================================================== */
+/*                       HAMT SUITE                      */
+/* ===================================================== */
+
+/* every set copies a path, past this the suite only measures the arena */
+#define BENCH_HAMT_MAX_KEYS Thousand(100)
+
+internal Nothing
+bench_hamt_ops(Bench* b, BenchKeys* hit, BenchKeys* miss, U64* order) {
+  U64 n = hit->count;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"hamt", "hamt", "insert", 0, hit->size, n, n, 0};
+  Hamt h = hamt_empty();
+  U64 sum = 0;
+
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    h = hamt_set_u64(b->arena, h, hit->keys[i], i);
+  }
+  bench_end(b, r);
+  AssertAlways(h.count == n);
+
+  r.op = "find-hit";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hamt_get(h, hit->keys[order[i]])->v_u64;
+  }
+  bench_end(b, r);
+
+  r.op = "find-miss";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hamt_get(h, miss->keys[order[i]]) != 0;
+  }
+  bench_end(b, r);
+
+  r.op = "update";
+  Hamt updated = h;
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    updated = hamt_set_u64(b->arena, updated, hit->keys[order[i]], n + i);
+  }
+  bench_end(b, r);
+  AssertAlways(updated.count == n);
+
+  r.op = "iterate";
+  bench_begin(b);
+  HashMapKV* kvs = hamt_kvs(b->arena, h);
+  for(U64 i = 0; i < h.count; ++i) {
+    sum += kvs[i].v_u64;
+  }
+  bench_end(b, r);
+
+  r.op = "remove";
+  Hamt removed = h;
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    removed = hamt_remove(b->arena, removed, hit->keys[order[i]]);
+  }
+  bench_end(b, r);
+  AssertAlways(removed.count == 0 && removed.root == 0);
+
+  /* the first version is untouched by everything built on top of it */
+  AssertAlways(h.count == n);
+  for(U64 i = 0; i < n; ++i) {
+    AssertAlways(hamt_get(h, hit->keys[i])->v_u64 == i);
+    AssertAlways(hamt_get(updated, hit->keys[order[i]])->v_u64 == n + i);
+  }
+
+  b->sink += sum;
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_hamt_ref(Bench* b, BenchKeys* hit, U64* order) {
+  U64 n = hit->count;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"hamt", "ref", "snapshot-get", 0, hit->size, n, n, 0};
+  HamtRef ref = {0};
+  Hamt h = hamt_empty();
+  for(U64 i = 0; i < n; ++i) {
+    h = hamt_set_u64(b->arena, h, hit->keys[i], i);
+  }
+  hamt_ref_publish(b->arena, &ref, h);
+  U64 sum = 0;
+
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hamt_get(hamt_ref_snapshot(&ref), hit->keys[order[i]])->v_u64;
+  }
+  bench_end(b, r);
+
+  b->sink += sum;
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_hamt(Bench* b) {
+  for(U64 si = 0; si < ArrayCount(bench_sizes); ++si) {
+    U64 n = bench_sizes[si];
+    if(n > b->max_keys || n > BENCH_HAMT_MAX_KEYS) {
+      break;
+    }
+
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    U64* order = bench_shuffle(b, n);
+    for(U64 ki = 0; ki < ArrayCount(bench_key_sizes); ++ki) {
+      U64 size = bench_key_sizes[ki];
+      if(!bench_keys_fit(n, size) || size > 64) {
+        continue;
+      }
+      ArenaScratch ks = arena_scratch_begin(b->arena);
+      BenchKeys hit = bench_keys(b, 0, n, size);
+      BenchKeys miss = bench_keys(b, n, n, size);
+      bench_hamt_ops(b, &hit, &miss, order);
+      bench_hamt_ref(b, &hit, order);
+      arena_scratch_end(ks);
+    }
+    arena_scratch_end(s);
+  }
+}
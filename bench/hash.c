@@ -0,0 +1,241 @@
+/* ===================================================== */
+/*                       HASH SUITE                      */
+/* ===================================================== */
+
+#define BENCH_HASH_KEYS 4096
+
+typedef U64 (*BenchHashFn)(Str8 key);
+
+typedef struct BenchHasher BenchHasher;
+struct BenchHasher {
+  CStr name;
+  BenchHashFn fn;
+};
+
+internal U64
+bench_hash_rapidhash(Str8 key) {
+  return rapidhash(key.cstr, key.size);
+}
+
+internal U64
+bench_hash_rapidhash_micro(Str8 key) {
+  return rapidhashMicro(key.cstr, key.size);
+}
+
+internal U64
+bench_hash_rapidhash_nano(Str8 key) {
+  return rapidhashNano(key.cstr, key.size);
+}
+
+internal U64
+bench_hash_stbds_string(Str8 key) {
+  return stbds_hash_string((char*)key.cstr, 1987);
+}
+
+internal U64
+bench_hash_hashmap_hasher(Str8 key) {
+  return hashmap_hasher(key);
+}
+
+internal U64
+bench_hash_adaptive(Str8 key) {
+  return hashmap_hash_with(HashMapHash_Adaptive, HASHMAP_DEFAULT_SEED, key);
+}
+
+internal U64
+bench_hash_int(Str8 key) {
+  return hashmap_hash_with(HashMapHash_Int, HASHMAP_DEFAULT_SEED, key);
+}
+
+internal BenchHasher bench_hashers[] = {
+  {"rapidhash", bench_hash_rapidhash},
+  {"rapidhashMicro", bench_hash_rapidhash_micro},
+  {"rapidhashNano", bench_hash_rapidhash_nano},
+  {"stbds_hash_string", bench_hash_stbds_string},
+  {"hashmap_hasher", bench_hash_hashmap_hasher},
+  {"hashmap_adaptive", bench_hash_adaptive},
+  {"hashmap_int", bench_hash_int},
+};
+
+typedef struct BenchHashDist BenchHashDist;
+struct BenchHashDist {
+  CStr name;
+  U64 min;
+  U64 max;
+};
+
+/* sizes roughly halve in frequency with every doubling past min */
+internal BenchHashDist bench_hash_dists[] = {
+  {"short", 1, 16},
+  {"ident", 4, 32},
+  {"path", 16, 128},
+  {"mixed", 1, 1024},
+  {"long", 256, 4096},
+};
+
+internal CStr bench_hash_strategies[] = {"rapid", "micro", "nano", "adaptive",
+                                         "int"
+                                        };
+
+/* scalar loop against hash_rapid_batch on the same keys, both write to an
+   array so the comparison only differs in how the multiplies overlap */
+internal Nothing
+bench_hash_batch(Bench* b, Str8* keys, U64 count, U64 rounds, CStr variant,
+                 U64 key_size, U64 bytes) {
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U64* scalar = arena_push_array_no_zero(b->arena, U64, count);
+  U64* batch = arena_push_array_no_zero(b->arena, U64, count);
+  BenchResult r = {"hash", "rapidhash", "scalar", variant, key_size, count,
+                   rounds * count, rounds * bytes
+                  };
+
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    for(U64 i = 0; i < count; ++i) {
+      scalar[i] = rapidhash_withSeed(keys[i].cstr, keys[i].size,
+                                     HASHMAP_DEFAULT_SEED);
+    }
+  }
+  bench_end(b, r);
+
+  r.op = "batch";
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    hash_rapid_batch(keys, batch, count, HASHMAP_DEFAULT_SEED);
+  }
+  bench_end(b, r);
+
+  for(U64 i = 0; i < count; ++i) {
+    AssertAlways(scalar[i] == batch[i]);
+  }
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_hash_dist(Bench* b, BenchHashDist* d) {
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  Str8* keys = arena_push_array_no_zero(b->arena, Str8, BENCH_HASH_KEYS);
+  U8* data = arena_push_array_no_zero(b->arena, U8, d->max);
+  U64 bytes = 0;
+
+  for(U64 i = 0; i < d->max; ++i) {
+    data[i] = (U8)bench_rand(b);
+  }
+  for(U64 i = 0; i < BENCH_HASH_KEYS; ++i) {
+    U64 size = d->min;
+    while(size * 2 <= d->max && (bench_rand(b) & 1)) {
+      size *= 2;
+    }
+    U64 extra = bench_rand(b) % size;
+    U64 at = bench_rand(b);
+    size = Min(d->max, size + extra);
+    keys[i] = str8_raw(data + at % (d->max - size + 1), size);
+    bytes += size;
+  }
+
+  U64 total = b->quick ? Thousand(200) : Million(8);
+  U64 rounds = Max(1, total / BENCH_HASH_KEYS / Max(1, d->max / 256));
+  for(HashMapHash h = 0; h < ArrayCount(bench_hash_strategies); ++h) {
+    BenchResult r = {"hash", bench_hash_strategies[h], "dist", d->name,
+                     bytes / BENCH_HASH_KEYS, BENCH_HASH_KEYS,
+                     rounds * BENCH_HASH_KEYS, rounds * bytes
+                    };
+    U64 sum = 0;
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(U64 i = 0; i < BENCH_HASH_KEYS; ++i) {
+        sum += hashmap_hash_with(h, HASHMAP_DEFAULT_SEED, keys[i]);
+      }
+    }
+    bench_end(b, r);
+    b->sink += sum;
+  }
+  bench_hash_batch(b, keys, BENCH_HASH_KEYS, rounds, d->name,
+                   bytes / BENCH_HASH_KEYS, bytes);
+  arena_scratch_end(s);
+}
+
+/* large buffer throughput: one call, 64k streaming updates and the tree
+   fingerprint on one and on every core */
+internal Nothing
+bench_hash_large(Bench* b) {
+  U64 size = b->quick ? MB(16) : MB(256);
+  U64 piece = KB(64);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U8* data = arena_push_array_no_zero(b->arena, U8, size);
+  for(U64 i = 0; i < size; i += sizeof(U64)) {
+    U64 r = bench_rand(b);
+    MemoryCopy(data + i, &r, sizeof(r));
+  }
+
+  BenchResult r = {"hash", "rapidhash", "oneshot", 0, piece, size,
+                   size / piece, size
+                  };
+  bench_begin(b);
+  U64 expected = rapidhash_withSeed(data, size, HASHMAP_DEFAULT_SEED);
+  bench_end(b, r);
+
+  r.structure = "stream";
+  r.op = "update";
+  r.variant = "64k";
+  HashRapidState st;
+  bench_begin(b);
+  hash_rapid_init(&st, HASHMAP_DEFAULT_SEED);
+  for(U64 at = 0; at < size; at += piece) {
+    hash_rapid_update(&st, data + at, piece);
+  }
+  U64 streamed = hash_rapid_final(&st);
+  bench_end(b, r);
+  AssertAlways(streamed == expected);
+
+  U32 threads[] = {1, 4, platform_get_cpu_cores()};
+  U64 trees[ArrayCount(threads)];
+  for(U64 t = 0; t < ArrayCount(threads); ++t) {
+    char variant[32];
+    snprintf(variant, sizeof(variant), "threads=%u", threads[t]);
+    BenchResult tr = {"hash", "tree", "hash", variant, HASH_TREE_LEAF, size,
+                      size / HASH_TREE_LEAF, size
+                     };
+    bench_begin(b);
+    trees[t] = hash_rapid_tree(data, size, HASHMAP_DEFAULT_SEED, threads[t]);
+    bench_end(b, tr);
+  }
+  AssertAlways(trees[0] == trees[1] && trees[0] == trees[2]);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_hash(Bench* b) {
+  U64 total = b->quick ? Thousand(200) : Million(8);
+
+  for(U64 ki = 0; ki < ArrayCount(bench_key_sizes); ++ki) {
+    U64 size = bench_key_sizes[ki];
+    U64 rounds = Max(1, total / BENCH_HASH_KEYS / Max(1, size / 64));
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    BenchKeys keys = bench_keys(b, 0, BENCH_HASH_KEYS, size);
+
+    for(U64 hi = 0; hi < ArrayCount(bench_hashers); ++hi) {
+      BenchHasher* h = bench_hashers + hi;
+      BenchResult r = {"hash", h->name, "hash", 0, size, BENCH_HASH_KEYS,
+                       rounds * BENCH_HASH_KEYS, rounds* BENCH_HASH_KEYS * size
+                      };
+      U64 sum = 0;
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        for(U64 i = 0; i < BENCH_HASH_KEYS; ++i) {
+          sum += h->fn(keys.keys[i]);
+        }
+      }
+      bench_end(b, r);
+      b->sink += sum;
+    }
+    bench_hash_batch(b, keys.keys, BENCH_HASH_KEYS, rounds, 0, size,
+                     BENCH_HASH_KEYS * size);
+    arena_scratch_end(s);
+  }
+
+  for(U64 di = 0; di < ArrayCount(bench_hash_dists); ++di) {
+    bench_hash_dist(b, bench_hash_dists + di);
+  }
+  bench_hash_large(b);
+}
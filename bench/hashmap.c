@@ -0,0 +1,214 @@
+/* ===================================================== */
+/*                     HASHMAP SUITE                     */
+/* ===================================================== */
+
+typedef struct BenchStbStr BenchStbStr;
+struct BenchStbStr {
+  char* key;
+  U64 value;
+};
+
+typedef struct BenchStbU64 BenchStbU64;
+struct BenchStbU64 {
+  U64 key;
+  U64 value;
+};
+
+internal Nothing
+bench_hashmap_sepi(Bench* b, BenchKeys* hit, BenchKeys* miss, U64* order) {
+  U64 n = hit->count;
+  BenchResult r = {"hashmap", "sepi", 0, 0, hit->size, n, n, 0};
+
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  r.op = "insert";
+  bench_begin(b);
+  HashMap* hm = hashmap_init(b->arena, n);
+  for(U64 i = 0; i < n; ++i) {
+    hashmap_push_u64(b->arena, hm, hit->keys[i], i);
+  }
+  bench_end(b, r);
+
+  U64 sum = 0;
+  r.op = "find-hit";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hashmap_find(hm, hit->keys[order[i]])->v_u64;
+  }
+  bench_end(b, r);
+
+  r.op = "find-miss";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hashmap_find(hm, miss->keys[order[i]]) != 0;
+  }
+  bench_end(b, r);
+
+  r.op = "iterate";
+  bench_begin(b);
+  for(U64 i = 0; i < hm->capacity; ++i) {
+    for(HashMapNode* itr = hm->list[i].first; itr != 0; itr = itr->next) {
+      sum += itr->kv.v_u64;
+    }
+  }
+  bench_end(b, r);
+
+  r.op = "pop";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hashmap_pop(hm, hit->keys[order[i]]).v_u64;
+  }
+  bench_end(b, r);
+  arena_scratch_end(s);
+
+  s = arena_scratch_begin(b->arena);
+  HashMapKV* kvs = arena_push_array_no_zero(b->arena, HashMapKV, n);
+  for(U64 i = 0; i < n; ++i) {
+    kvs[i] = (HashMapKV) {
+      .k_str = hit->keys[i], .v_u64 = i
+    };
+  }
+  r.structure = "sepi-build";
+  r.op = "insert";
+  bench_begin(b);
+  hm = hashmap_build(b->arena, n, kvs, n, 0);
+  bench_end(b, r);
+
+  r.op = "find-hit";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hashmap_find(hm, hit->keys[order[i]])->v_u64;
+  }
+  bench_end(b, r);
+
+  r.op = "iterate";
+  bench_begin(b);
+  for(U64 i = 0; i < hm->capacity; ++i) {
+    for(HashMapNode* itr = hm->list[i].first; itr != 0; itr = itr->next) {
+      sum += itr->kv.v_u64;
+    }
+  }
+  bench_end(b, r);
+  arena_scratch_end(s);
+
+  b->sink += sum;
+}
+
+internal Nothing
+bench_hashmap_stb_str(Bench* b, BenchKeys* hit, BenchKeys* miss, U64* order) {
+  U64 n = hit->count;
+  BenchResult r = {"hashmap", "stb-shmap", 0, 0, hit->size, n, n, 0};
+  BenchStbStr* map = 0;
+  U64 sum = 0;
+
+  r.op = "insert";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    shput(map, (char*)hit->keys[i].cstr, i);
+  }
+  bench_end(b, r);
+
+  r.op = "find-hit";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += shget(map, (char*)hit->keys[order[i]].cstr);
+  }
+  bench_end(b, r);
+
+  r.op = "find-miss";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += shgeti(map, (char*)miss->keys[order[i]].cstr) >= 0;
+  }
+  bench_end(b, r);
+
+  r.op = "iterate";
+  bench_begin(b);
+  for(I64 i = 0; i < shlen(map); ++i) {
+    sum += map[i].value;
+  }
+  bench_end(b, r);
+
+  r.op = "pop";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += shdel(map, (char*)hit->keys[order[i]].cstr);
+  }
+  bench_end(b, r);
+
+  shfree(map);
+  b->sink += sum;
+}
+
+internal Nothing
+bench_hashmap_stb_u64(Bench* b, U64 n, U64* order) {
+  BenchResult r = {"hashmap", "stb-hmap", 0, 0, sizeof(U64), n, n, 0};
+  BenchStbU64* map = 0;
+  U64 salt = bench_rand(b);
+  U64 sum = 0;
+
+  r.op = "insert";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    hmput(map, i ^ salt, i);
+  }
+  bench_end(b, r);
+
+  r.op = "find-hit";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hmget(map, order[i] ^ salt);
+  }
+  bench_end(b, r);
+
+  r.op = "find-miss";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hmgeti(map, (order[i] + n) ^ salt) >= 0;
+  }
+  bench_end(b, r);
+
+  r.op = "iterate";
+  bench_begin(b);
+  for(I64 i = 0; i < hmlen(map); ++i) {
+    sum += map[i].value;
+  }
+  bench_end(b, r);
+
+  r.op = "pop";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += hmdel(map, order[i] ^ salt);
+  }
+  bench_end(b, r);
+
+  hmfree(map);
+  b->sink += sum;
+}
+
+internal Nothing
+bench_hashmap(Bench* b) {
+  for(U64 si = 0; si < ArrayCount(bench_sizes); ++si) {
+    U64 n = bench_sizes[si];
+    if(n > b->max_keys) {
+      break;
+    }
+
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    U64* order = bench_shuffle(b, n);
+    bench_hashmap_stb_u64(b, n, order);
+
+    for(U64 ki = 0; ki < ArrayCount(bench_key_sizes); ++ki) {
+      U64 size = bench_key_sizes[ki];
+      if(!bench_keys_fit(n, size) || (b->quick && size > 64)) {
+        continue;
+      }
+      ArenaScratch ks = arena_scratch_begin(b->arena);
+      BenchKeys hit = bench_keys(b, 0, n, size);
+      BenchKeys miss = bench_keys(b, n, n, size);
+      bench_hashmap_sepi(b, &hit, &miss, order);
+      bench_hashmap_stb_str(b, &hit, &miss, order);
+      arena_scratch_end(ks);
+    }
+    arena_scratch_end(s);
+  }
+}
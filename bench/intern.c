@@ -0,0 +1,123 @@
+/* ===================================================== */
+/*                      INTERN SUITE                     */
+/* ===================================================== */
+
+internal Nothing
+bench_intern_single(Bench* b, BenchKeys* hit, BenchKeys* miss, U64* order) {
+  U64 n = hit->count;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"intern", "single", "insert", 0, hit->size, n, n, 0};
+  Symbol* ids = arena_push_array_no_zero(b->arena, Symbol, n);
+  InternTable* it = intern_init(b->arena, n);
+  U64 sum = 0;
+
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    ids[i] = intern_str8(it, hit->keys[i]);
+  }
+  bench_end(b, r);
+  AssertAlways(it->count == n);
+
+  r.op = "insert-dup";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += intern_str8(it, hit->keys[order[i]]);
+  }
+  bench_end(b, r);
+  AssertAlways(it->count == n);
+
+  r.op = "find-miss";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += intern_find(it, miss->keys[order[i]]);
+  }
+  bench_end(b, r);
+
+  r.op = "lookup";
+  bench_begin(b);
+  for(U64 i = 0; i < n; ++i) {
+    sum += intern_lookup(it, ids[order[i]]).size;
+  }
+  bench_end(b, r);
+
+  for(U64 i = 0; i < n; ++i) {
+    AssertAlways(str8_cmp(intern_lookup(it, ids[i]), hit->keys[i], 0));
+  }
+
+  b->sink += sum;
+  intern_release(it);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_intern_bulk(Bench* b, BenchKeys* hit, Bool sync) {
+  U64 n = hit->count;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchResult r = {"intern", sync ? "bulk-sync" : "bulk", "insert", 0,
+                   hit->size, n, n, 0};
+  Symbol* ids = arena_push_array_no_zero(b->arena, Symbol, n);
+  InternTable* it = intern_init(b->arena, n);
+
+  bench_begin(b);
+  if(sync) {
+    intern_bulk_sync(it, hit->keys, ids, n);
+  } else {
+    intern_bulk(it, hit->keys, ids, n);
+  }
+  bench_end(b, r);
+
+  AssertAlways(it->count == n);
+  for(U64 i = 0; i < n; ++i) {
+    AssertAlways(ids[i] == i + 1);
+  }
+  intern_release(it);
+  arena_scratch_end(s);
+}
+
+/* crosses the initial chunk table so lookups also cover a grown one */
+internal Nothing
+bench_intern_grow(Bench* b) {
+  U64 n = INTERN_CHUNK_SIZE * INTERN_INITIAL_CHUNKS + 2;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  BenchKeys keys = bench_keys(b, 0, n, 8);
+  InternTable* it = intern_init(b->arena, n);
+  Str8** initial = it->chunks;
+
+  intern_bulk(it, keys.keys, arena_push_array_no_zero(b->arena, Symbol, n), n);
+  AssertAlways(it->chunks != initial && it->chunk_capacity > INTERN_INITIAL_CHUNKS);
+  for(U64 i = 0; i < n; i += INTERN_CHUNK_SIZE / 4) {
+    AssertAlways(str8_cmp(intern_lookup(it, (Symbol)(i + 1)), keys.keys[i], 0));
+  }
+  AssertAlways(str8_cmp(intern_lookup(it, (Symbol)n), keys.keys[n - 1], 0));
+  AssertAlways(intern_lookup(it, (Symbol)(n + 1)).size == 0);
+  intern_release(it);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_intern(Bench* b) {
+  bench_intern_grow(b);
+  for(U64 si = 0; si < ArrayCount(bench_sizes); ++si) {
+    U64 n = bench_sizes[si];
+    if(n > b->max_keys) {
+      break;
+    }
+
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    U64* order = bench_shuffle(b, n);
+    for(U64 ki = 0; ki < ArrayCount(bench_key_sizes); ++ki) {
+      U64 size = bench_key_sizes[ki];
+      if(!bench_keys_fit(n, size) || size > 64) {
+        continue;
+      }
+      ArenaScratch ks = arena_scratch_begin(b->arena);
+      BenchKeys hit = bench_keys(b, 0, n, size);
+      BenchKeys miss = bench_keys(b, n, n, size);
+      bench_intern_single(b, &hit, &miss, order);
+      bench_intern_bulk(b, &hit, FALSE);
+      bench_intern_bulk(b, &hit, TRUE);
+      arena_scratch_end(ks);
+    }
+    arena_scratch_end(s);
+  }
+}
@@ -0,0 +1,469 @@
+/* ===================================================== */
+/*                        IO SUITE                       */
+/* ===================================================== */
+
+#define BENCH_IO_PATH "/tmp/sepi_bench_io.bin"
+#define BENCH_IO_DIR "/tmp/sepi_bench_io"
+#define BENCH_IO_TREE "/tmp/sepi_bench_io_tree"
+
+internal U64 bench_io_sizes[] = {KB(4), MB(1), MB(64), GB(1), GB(10)};
+
+/* written in 1 MB pieces of random bytes, so it is in the page cache
+   when the timing starts; FALSE when the disk can't hold it */
+internal Bool
+bench_io_file(Bench* b, CStr path, U64 size) {
+  FILE* f = fopen(path, "wb");
+  if(!f) {
+    return FALSE;
+  }
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U64* piece = arena_push_array_no_zero(b->arena, U64, MB(1) / sizeof(U64));
+  Bool ok = TRUE;
+  for(U64 at = 0; ok && at < size; at += MB(1)) {
+    for(U64 i = 0; i < MB(1) / sizeof(U64); ++i) {
+      piece[i] = bench_rand(b);
+    }
+    U64 n = Min(MB(1), size - at);
+    ok = fwrite(piece, 1, n, f) == n;
+  }
+  ok &= fclose(f) == 0;
+  arena_scratch_end(s);
+  if(!ok) {
+    remove(path);
+  }
+  return ok;
+}
+
+/* what a caller does with the bytes: every one of them is read once */
+internal U64
+bench_io_touch(CBuf data, U64 size) {
+  U64 sum = 0;
+  U64 i = 0;
+  for(; i + sizeof(U64) <= size; i += sizeof(U64)) {
+    U64 word;
+    MemoryCopy(&word, data + i, sizeof(U64));
+    sum += word;
+  }
+  for(; i < size; ++i) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+internal Nothing
+bench_io_whole(Bench* b) {
+  IoMapFlags flags[] = {
+    0,
+    IoMapFlag_Sequential | IoMapFlag_WillNeed,
+    IoMapFlag_Sequential | IoMapFlag_WillNeed | IoMapFlag_HugePages,
+  };
+  CStr variants[] = {"plain", "sequential", "hugepage"};
+  U64 memory = (U64)sysconf(_SC_PHYS_PAGES) * (U64)sysconf(_SC_PAGESIZE);
+  U64 sizes = b->quick ? 3 : ArrayCount(bench_io_sizes);
+
+  Buf missing = (Buf)1;
+  AssertAlways(io_load_file(BENCH_IO_DIR "/missing", &missing) == 0 && missing == 0);
+
+  /* procfs reports size 0, so the buffer grows and has to do it in place */
+  ArenaScratch ps = arena_scratch_begin(b->arena);
+  U64 position = arena_get_position(b->arena);
+  Str8 maps = io_load_file_arena(b->arena, "/proc/self/maps");
+  AssertAlways(maps.cstr && maps.size);
+  AssertAlways(arena_get_position(b->arena) - position <= maps.size + 8);
+  arena_scratch_end(ps);
+
+  for(U64 si = 0; si < sizes; ++si) {
+    U64 size = bench_io_sizes[si];
+    if(!bench_io_file(b, BENCH_IO_PATH, size)) {
+      printf("io: no room for a %llu byte file, skipped\n", (unsigned long long)size);
+      continue;
+    }
+    U64 rounds = Max(1, (b->quick ? MB(256) : GB(2)) / size);
+    BenchResult r = {"io", "io_load_file", "load", "malloc", 0, size, rounds,
+                     rounds * size
+                    };
+    U64 sum = 0;
+
+    /* the whole file has to fit in memory next to the page cache */
+    if(size <= memory / 2) {
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        Buf data = 0;
+        U64 loaded = io_load_file(BENCH_IO_PATH, &data);
+        AssertAlways(data && loaded == size);
+        sum = bench_io_touch(data, loaded);
+        free(data);
+      }
+      bench_end(b, r);
+
+      U64 check = 0;
+      r.structure = "io_load_file_arena";
+      r.variant = "arena";
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        ArenaScratch s = arena_scratch_begin(b->arena);
+        Str8 data = io_load_file_arena(b->arena, BENCH_IO_PATH);
+        AssertAlways(data.cstr && data.size == size);
+        check = bench_io_touch((CBuf)data.cstr, data.size);
+        arena_scratch_end(s);
+      }
+      bench_end(b, r);
+      AssertAlways(check == sum);
+    }
+
+    r.structure = "io_map_file";
+    r.op = "map";
+    for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+      U64 check = 0;
+      r.variant = variants[fi];
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        Str8 view = io_map_file(BENCH_IO_PATH, flags[fi]);
+        AssertAlways(view.cstr && view.size == size);
+        check = bench_io_touch((CBuf)view.cstr, view.size);
+        io_unmap_file(view);
+      }
+      bench_end(b, r);
+      AssertAlways(size > memory / 2 || check == sum);
+      b->sink += check;
+    }
+    remove(BENCH_IO_PATH);
+  }
+}
+
+/* a directory of small files, 64 bytes to 16 KB, like assets and configs */
+internal CStr*
+bench_io_dir(Bench* b, U64 count) {
+  CStr* paths = arena_push_array_no_zero(b->arena, CStr, count);
+  U8 bytes[KB(16)];
+  mkdir(BENCH_IO_DIR, 0755);
+  for(U64 i = 0; i < count; ++i) {
+    paths[i] = str8f(b->arena, BENCH_IO_DIR "/%05llu.dat", (unsigned long long)i).cstr;
+    U64 size = 64 + bench_rand(b) % (sizeof(bytes) - 64);
+    for(U64 k = 0; k < size; ++k) {
+      bytes[k] = (U8)bench_rand(b);
+    }
+    FILE* f = fopen(paths[i], "wb");
+    AssertAlways(f && fwrite(bytes, 1, size, f) == size && fclose(f) == 0);
+  }
+  return paths;
+}
+
+internal Nothing
+bench_io_batch_touch(RawPtr user, IoLoad* load) {
+  *(U64*)user += bench_io_touch((CBuf)load->data.cstr, load->data.size);
+}
+
+internal Nothing
+bench_io_batch(Bench* b) {
+  U64 count = b->quick ? Thousand(2) : Thousand(10);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  CStr* paths = bench_io_dir(b, count);
+  U64 sum = 0;
+
+  BenchResult r = {"io", "io_load_file", "batch", "serial", 0, count, count, 0};
+  bench_begin(b);
+  for(U64 i = 0; i < count; ++i) {
+    Buf data = 0;
+    U64 size = io_load_file(paths[i], &data);
+    sum += bench_io_touch(data, size);
+    r.bytes += size;
+    free(data);
+  }
+  bench_end(b, r);
+
+  U64 check = 0;
+  r.structure = "io_load_file_arena";
+  bench_begin(b);
+  ArenaScratch rs = arena_scratch_begin(b->arena);
+  for(U64 i = 0; i < count; ++i) {
+    Str8 data = io_load_file_arena(b->arena, paths[i]);
+    check += bench_io_touch((CBuf)data.cstr, data.size);
+  }
+  arena_scratch_end(rs);
+  bench_end(b, r);
+  AssertAlways(check == sum);
+
+  IoBatchFlags flags[] = {0, IoBatchFlag_NoUring};
+  CStr variants[] = {"uring", "threads"};
+  r.structure = "io_load_files";
+  for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+    check = 0;
+    r.variant = variants[fi];
+    bench_begin(b);
+    rs = arena_scratch_begin(b->arena);
+    IoLoad* loads = io_load_files(b->arena, paths, count, flags[fi], bench_io_batch_touch,
+                                  &check);
+    for(U64 i = 0; i < count; ++i) {
+      AssertAlways(loads[i].data.cstr && !loads[i].error);
+    }
+    arena_scratch_end(rs);
+    bench_end(b, r);
+    AssertAlways(check == sum);
+  }
+
+  for(U64 i = 0; i < count; ++i) {
+    remove(paths[i]);
+  }
+  rmdir(BENCH_IO_DIR);
+  b->sink += sum;
+  arena_scratch_end(s);
+}
+
+/* a record parser's share of a window: records end at a newline, the
+   cut one at the end is left for the next window unless it is the last */
+internal U64
+bench_io_records(Str8 window, Bool last, U64* records) {
+  const U8* p = (const U8*)window.cstr;
+  const U8* end = p + window.size;
+  U64 count = 0;
+  U64 used = 0;
+  for(const U8* nl = memchr(p, '\n', window.size); nl;
+      nl = memchr(nl + 1, '\n', (Sz)(end - nl - 1))) {
+    count += 1;
+    used = (U64)(nl + 1 - p);
+  }
+  *records += count;
+  return last ? window.size : used;
+}
+
+internal Nothing
+bench_io_stream(Bench* b) {
+  IoStreamFlags flags[] = {0, IoStreamFlag_NoThread};
+  CStr variants[] = {"thread", "fadvise"};
+  U64 size = b->quick ? MB(64) : GB(1);
+  if(!bench_io_file(b, BENCH_IO_PATH, size)) {
+    printf("io: no room for a %llu byte file, skipped\n", (unsigned long long)size);
+    return;
+  }
+  U64 rounds = Max(1, (b->quick ? MB(256) : GB(4)) / size);
+  BenchResult r = {"io", "io_load_file_arena", "stream", "whole", 0, size, rounds,
+                   rounds * size
+                  };
+  U64 want = 0;
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    Str8 data = io_load_file_arena(b->arena, BENCH_IO_PATH);
+    AssertAlways(data.size == size);
+    want = 0;
+    bench_io_records(data, TRUE, &want);
+    arena_scratch_end(s);
+  }
+  bench_end(b, r);
+
+  r.structure = "io_stream";
+  for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+    r.variant = variants[fi];
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch s = arena_scratch_begin(b->arena);
+      IoStream* stream = io_stream_open(b->arena, BENCH_IO_PATH, 0, flags[fi]);
+      AssertAlways(stream);
+      U64 records = 0;
+      U64 used = 0;
+      for(Str8 window = io_stream_next(stream, 0); window.size;
+          window = io_stream_next(stream, used)) {
+        used = bench_io_records(window, stream->last, &records);
+      }
+      AssertAlways(!stream->error && records == want);
+      io_stream_close(stream);
+      arena_scratch_end(s);
+    }
+    bench_end(b, r);
+  }
+  b->sink += want;
+  remove(BENCH_IO_PATH);
+}
+
+/* records of 16 to 272 bytes, the way a log or an export comes out */
+internal Nothing
+bench_io_write(Bench* b) {
+  U64 size = b->quick ? MB(32) : MB(512);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U8* source = arena_push_array_no_zero(b->arena, U8, MB(1) + 512);
+  for(U64 i = 0; i < MB(1) + 512; ++i) {
+    source[i] = (U8)bench_rand(b);
+  }
+  U64 count = 0;
+  U64* lengths = arena_push_array_no_zero(b->arena, U64, size / 16);
+  for(U64 at = 0; at < size; at += lengths[count++]) {
+    U64 length = 16 + bench_rand(b) % 256;
+    lengths[count] = Min(length, size - at);
+  }
+  struct stat st;
+
+  CStr stdio_variants[] = {"unbuffered", "buffered"};
+  BenchResult r = {"io", "fwrite", "write", "", 0, size, count, size};
+  for(U64 vi = 0; vi < ArrayCount(stdio_variants); ++vi) {
+    r.variant = stdio_variants[vi];
+    bench_begin(b);
+    FILE* f = fopen(BENCH_IO_PATH, "wb");
+    AssertAlways(f);
+    if(vi == 0) {
+      setvbuf(f, 0, _IONBF, 0);
+    }
+    for(U64 i = 0, at = 0; i < count; at += lengths[i++]) {
+      fwrite(source + at % MB(1), 1, lengths[i], f);
+    }
+    AssertAlways(fclose(f) == 0);
+    bench_end(b, r);
+    AssertAlways(stat(BENCH_IO_PATH, &st) == 0 && (U64)st.st_size == size);
+  }
+
+  IoWriteFlags flags[] = {0, 0, IoWriteFlag_Atomic, IoWriteFlag_Direct};
+  U64 reserves[] = {0, size, 0, size};
+  CStr variants[] = {"plain", "reserve", "atomic", "direct"};
+  r.structure = "io_writer";
+  for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+    r.variant = variants[fi];
+    bench_begin(b);
+    ArenaScratch ws = arena_scratch_begin(b->arena);
+    IoWriter* w = io_writer_open(b->arena, BENCH_IO_PATH, 0, reserves[fi], flags[fi]);
+    AssertAlways(w);
+    for(U64 i = 0, at = 0; i < count; at += lengths[i++]) {
+      io_write(w, str8_raw(source + at % MB(1), lengths[i]));
+    }
+    AssertAlways(io_writer_close(w) == 0);
+    arena_scratch_end(ws);
+    bench_end(b, r);
+    AssertAlways(stat(BENCH_IO_PATH, &st) == 0 && (U64)st.st_size == size);
+  }
+  remove(BENCH_IO_PATH);
+  arena_scratch_end(s);
+}
+
+/* an asset tree: 16 folders of 16 folders of files up to 2 KB, a quarter
+   of them .png */
+internal U64
+bench_io_tree(Bench* b, U64 files, CStr* dirs) {
+  U8 bytes[KB(2)];
+  U64 matches = 0;
+  mkdir(BENCH_IO_TREE, 0755);
+  for(U64 d = 0; d < 16 * 16; ++d) {
+    dirs[d] = str8f(b->arena, BENCH_IO_TREE "/%02llu/%02llu", (unsigned long long)(d / 16),
+                    (unsigned long long)(d % 16)).cstr;
+    if(d % 16 == 0) {
+      CStr top = str8f(b->arena, BENCH_IO_TREE "/%02llu", (unsigned long long)(d / 16)).cstr;
+      mkdir(top, 0755);
+    }
+    mkdir(dirs[d], 0755);
+  }
+  for(U64 i = 0; i < files; ++i) {
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    Bool png = i % 4 == 0;
+    CStr path = str8f(b->arena, "%s/%06llu.%s", dirs[i % 256], (unsigned long long)i,
+                      png ? "png" : "txt").cstr;
+    U64 size = bench_rand(b) % sizeof(bytes);
+    for(U64 k = 0; k < size; ++k) {
+      bytes[k] = (U8)bench_rand(b);
+    }
+    FILE* f = fopen(path, "wb");
+    AssertAlways(f && fwrite(bytes, 1, size, f) == size && fclose(f) == 0);
+    matches += png;
+    arena_scratch_end(s);
+  }
+  return matches;
+}
+
+/* the walk everyone writes first: readdir, then an lstat of every name
+   to tell folders from files */
+internal Nothing
+bench_io_walk(Bench* b, CStr dir, Bool load, U64* files, U64* bytes) {
+  DIR* d = opendir(dir);
+  AssertAlways(d);
+  for(struct dirent* e = readdir(d); e; e = readdir(d)) {
+    if(e->d_name[0] == '.') {
+      continue;
+    }
+    CStr path = str8f(b->arena, "%s/%s", dir, e->d_name).cstr;
+    U64 size = strlen(path);
+    struct stat st;
+    AssertAlways(lstat(path, &st) == 0);
+    if(S_ISDIR(st.st_mode)) {
+      bench_io_walk(b, path, load, files, bytes);
+    } else if(S_ISREG(st.st_mode) && size > 4 && IsMemoryEq(path + size - 4, ".png", 4)) {
+      *files += 1;
+      *bytes += (U64)st.st_size;
+      if(load) {
+        Str8 data = io_load_file_arena(b->arena, path);
+        AssertAlways(data.size == (U64)st.st_size);
+      }
+    }
+  }
+  closedir(d);
+}
+
+internal Nothing
+bench_io_scan(Bench* b) {
+  U64 files = b->quick ? Thousand(10) : Thousand(100);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  CStr* dirs = arena_push_array_no_zero(b->arena, CStr, 16 * 16);
+  U64 matches = bench_io_tree(b, files, dirs);
+  U32 cores = platform_get_cpu_cores();
+  Str8 glob = str8("**/*.png");
+
+  for(U64 load = 0; load < 2; ++load) {
+    BenchResult r = {"io", "readdir", load ? "scan+load" : "scan", "serial", 0, files,
+                     matches, 0
+                    };
+    U64 walked = 0;
+    U64 want = 0;
+    bench_begin(b);
+    ArenaScratch rs = arena_scratch_begin(b->arena);
+    bench_io_walk(b, BENCH_IO_TREE, load, &walked, &want);
+    arena_scratch_end(rs);
+    r.bytes = load ? want : 0;
+    bench_end(b, r);
+    AssertAlways(walked == matches);
+
+    U32 threads[] = {1, cores};
+    CStr variants[] = {"serial", "threads"};
+    r.structure = "io_scan";
+    for(U64 ti = 0; ti < ArrayCount(threads); ++ti) {
+      r.variant = variants[ti];
+      r.key_size = threads[ti];
+      bench_begin(b);
+      rs = arena_scratch_begin(b->arena);
+      IoScan scan = io_scan(b->arena, BENCH_IO_TREE, glob, load ? IoScanFlag_Load : 0,
+                            threads[ti]);
+      AssertAlways(!scan.error && scan.count == matches && scan.directories == 16 * 17 + 1);
+      U64 bytes = 0;
+      for(U64 i = 0; i < scan.count; ++i) {
+        AssertAlways(!load || (scan.entries[i].data.cstr &&
+                               scan.entries[i].data.size == scan.entries[i].size));
+        bytes += scan.entries[i].size;
+      }
+      AssertAlways(bytes == want);
+      arena_scratch_end(rs);
+      bench_end(b, r);
+    }
+  }
+
+  for(U64 i = 0; i < files; ++i) {
+    ArenaScratch fs = arena_scratch_begin(b->arena);
+    remove(str8f(b->arena, "%s/%06llu.%s", dirs[i % 256], (unsigned long long)i,
+                 i % 4 == 0 ? "png" : "txt").cstr);
+    arena_scratch_end(fs);
+  }
+  for(U64 d = 0; d < 16 * 16; ++d) {
+    rmdir(dirs[d]);
+    if(d % 16 == 15) {
+      ArenaScratch fs = arena_scratch_begin(b->arena);
+      rmdir(str8f(b->arena, BENCH_IO_TREE "/%02llu", (unsigned long long)(d / 16)).cstr);
+      arena_scratch_end(fs);
+    }
+  }
+  rmdir(BENCH_IO_TREE);
+  b->sink += matches;
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_io(Bench* b) {
+  bench_io_whole(b);
+  bench_io_batch(b);
+  bench_io_stream(b);
+  bench_io_write(b);
+  bench_io_scan(b);
+}
@@ -0,0 +1,285 @@
+/* ===================================================== */
+/*                       JSON SUITE                      */
+/* ===================================================== */
+
+#define BENCH_JSON_LOOKUP_KEYS 4096
+
+typedef U32 BenchJsonCorpus;
+enum {
+  BenchJsonCorpus_Records,
+  BenchJsonCorpus_Numbers,
+  BenchJsonCorpus_Strings,
+};
+
+internal CStr bench_json_corpora[] = {"records", "numbers", "strings"};
+
+internal U64
+bench_json_word(Bench* b, U8* out) {
+  CStr segment = bench_string_segments[bench_rand(b) %
+                                       ArrayCount(bench_string_segments)];
+  U64 n = strlen(segment);
+  MemoryCopy(out, segment, n);
+  return n;
+}
+
+/* a top level array of `size` bytes or a little under */
+internal Str8
+bench_json_text(Bench* b, BenchJsonCorpus corpus, U64 size) {
+  U8* text = arena_push_array_no_zero(b->arena, U8, size);
+  U64 at = 0;
+  text[at++] = '[';
+  while(at + 512 < size) {
+    if(at > 1) {
+      text[at++] = ',';
+    }
+    if(corpus == BenchJsonCorpus_Records) {
+      U64 value = bench_rand(b);
+      at += (U64)sprintf((char*)text + at,
+                         "\n  {\"id\": %llu, \"score\": %.4f, \"active\": %s, "
+                         "\"tags\": [\"",
+                         (unsigned long long)(value >> 40), (F64)(value & 0xFFFFF) / 977.0,
+                         value & 1 ? "true" : "false");
+      at += bench_json_word(b, text + at);
+      at += (U64)sprintf((char*)text + at, "\", \"");
+      at += bench_json_word(b, text + at);
+      at += (U64)sprintf((char*)text + at, "\"], \"owner\": {\"name\": \"");
+      at += bench_json_word(b, text + at);
+      at += (U64)sprintf((char*)text + at, "\", \"parent\": null}}");
+    } else if(corpus == BenchJsonCorpus_Numbers) {
+      U64 bits = bench_rand(b);
+      at += (U64)sprintf((char*)text + at, "[%.17g, %lld, %.3f]",
+                         (F64)(bits >> 11) / (F64)(1ull << (bits % 48)),
+                         (long long)(I32)bits, (F64)(bits % 100000) / 7.0);
+    } else {
+      text[at++] = '"';
+      U64 words = 4 + bench_rand(b) % 16;
+      for(U64 w = 0; w < words; ++w) {
+        at += bench_json_word(b, text + at);
+        U64 pick = bench_rand(b) % 16;
+        CStr gap = pick == 0 ? "\\n" : pick == 1 ? "\\\"" : pick == 2 ? "\\u00e9" : " ";
+        at += (U64)sprintf((char*)text + at, "%s", gap);
+      }
+      text[at++] = '"';
+    }
+  }
+  text[at++] = ']';
+  return str8_raw(text, at);
+}
+
+/* the byte at a time recursive descent everyone writes first; counts
+   values and converts numbers with strtod */
+typedef struct BenchJsonScalar BenchJsonScalar;
+struct BenchJsonScalar {
+  const U8* p;
+  U64 at;
+  U64 size;
+  U64 values;
+  F64 sum;
+  Bool ok;
+};
+
+internal Nothing
+bench_json_scalar_space(BenchJsonScalar* j) {
+  while(j->at < j->size && (j->p[j->at] == ' ' || j->p[j->at] == '\n' ||
+                            j->p[j->at] == '\t' || j->p[j->at] == '\r')) {
+    j->at += 1;
+  }
+}
+
+internal Nothing
+bench_json_scalar_string(BenchJsonScalar* j) {
+  j->at += 1;
+  while(j->at < j->size && j->p[j->at] != '"') {
+    j->at += j->p[j->at] == '\\' ? 2 : 1;
+  }
+  j->ok &= j->at < j->size;
+  j->at += 1;
+}
+
+internal Nothing
+bench_json_scalar_value(BenchJsonScalar* j) {
+  bench_json_scalar_space(j);
+  if(!j->ok || j->at >= j->size) {
+    j->ok = FALSE;
+    return;
+  }
+  U8 c = j->p[j->at];
+  j->values += 1;
+  if(c == '{' || c == '[') {
+    U8 close = c == '{' ? '}' : ']';
+    j->at += 1;
+    bench_json_scalar_space(j);
+    if(j->at < j->size && j->p[j->at] == close) {
+      j->at += 1;
+      return;
+    }
+    while(j->ok) {
+      if(c == '{') {
+        bench_json_scalar_space(j);
+        bench_json_scalar_string(j);
+        bench_json_scalar_space(j);
+        j->ok &= j->at < j->size && j->p[j->at] == ':';
+        j->at += 1;
+      }
+      bench_json_scalar_value(j);
+      bench_json_scalar_space(j);
+      if(j->at < j->size && j->p[j->at] == ',') {
+        j->at += 1;
+      } else {
+        j->ok &= j->at < j->size && j->p[j->at] == close;
+        j->at += 1;
+        return;
+      }
+    }
+  } else if(c == '"') {
+    bench_json_scalar_string(j);
+  } else if(c == 't' || c == 'n') {
+    j->at += 4;
+  } else if(c == 'f') {
+    j->at += 5;
+  } else {
+    char* end = 0;
+    j->sum += strtod((const char*)j->p + j->at, &end);
+    j->ok &= end != (const char*)j->p + j->at;
+    j->at = (U64)((const U8*)end - j->p);
+  }
+}
+
+internal U64
+bench_json_count(JsonValue* root) {
+  U64 result = 0;
+  JsonValue* end = root + root->span;
+  for(JsonValue* v = root; v < end; ++v) {
+    result += 1;
+    if(v->kind == JsonKind_Object) {
+      result -= v->count;
+    }
+  }
+  return result;
+}
+
+internal Nothing
+bench_json_parse(Bench* b) {
+  U64 size = b->quick ? MB(4) : MB(64);
+  U64 rounds = b->quick ? 2 : 4;
+
+  for(U64 ci = 0; ci < ArrayCount(bench_json_corpora); ++ci) {
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    Str8 text = bench_json_text(b, (BenchJsonCorpus)ci, size);
+    BenchResult r = {"json", "scalar", "parse", bench_json_corpora[ci], 0,
+                     text.size, rounds, rounds * text.size
+                    };
+    U64 values = 0;
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      BenchJsonScalar j = {(const U8*)text.cstr, 0, text.size, 0, 0, TRUE};
+      bench_json_scalar_value(&j);
+      AssertAlways(j.ok);
+      values = j.values;
+      b->sink += (U64)j.sum;
+    }
+    bench_end(b, r);
+
+    r.structure = "json_parse";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      JsonDocument* doc = json_parse(b->arena, text);
+      AssertAlways(json_root(doc) && bench_json_count(json_root(doc)) == values);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+
+    /* the size check comes before anything reads the source */
+    JsonDocument* big = json_parse(b->arena, str8_raw((U8*)text.cstr, JSON_MAX_SIZE));
+    AssertAlways(big->error == JsonError_Size && json_root(big) == 0);
+    arena_scratch_end(s);
+  }
+}
+
+/* one object of BENCH_JSON_LOOKUP_KEYS members, looked up by every key
+   through its hash index and by walking the members */
+internal Nothing
+bench_json_lookup(Bench* b) {
+  U64 n = BENCH_JSON_LOOKUP_KEYS;
+  U64 lookups = b->quick ? Thousand(100) : Million(2);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  Str8List list = {0};
+  Str8* keys = arena_push_array_no_zero(b->arena, Str8, n);
+  str8_list_push(b->arena, &list, str8("{"));
+  for(U64 i = 0; i < n; ++i) {
+    keys[i] = str8f(b->arena, "%s_%llu", bench_string_segments[i % ArrayCount(bench_string_segments)],
+                    (unsigned long long)i);
+    str8_list_pushf(b->arena, &list, "%s\"%.*s\": %llu", i ? ", " : "",
+                    (int)keys[i].size, keys[i].cstr, (unsigned long long)i);
+  }
+  str8_list_push(b->arena, &list, str8("}"));
+  Str8 text = str8_list_join(b->arena, &list, str8(""));
+  JsonValue* object = json_root(json_parse(b->arena, text));
+  AssertAlways(object && object->index);
+
+  /* a walk costs n / 2 compares on average, so it gets fewer rounds */
+  U64 walks = lookups / 32;
+  U64 sum = 0;
+  BenchResult r = {"json", "members", "get", "linear", 0, n, walks, 0};
+  bench_begin(b);
+  for(U64 i = 0; i < walks; ++i) {
+    Str8 key = keys[(i * 2654435761u) % n];
+    for(JsonValue* k = json_first(object); k; k = json_next(object, k)) {
+      if(str8_cmp(k->text, key, 0)) {
+        sum += (U64)json_i64(k + 1);
+        break;
+      }
+    }
+  }
+  bench_end(b, r);
+
+  U64 check = 0;
+  r.structure = "json_get";
+  r.variant = "hashmap";
+  r.ops = lookups;
+  bench_begin(b);
+  for(U64 i = 0; i < lookups; ++i) {
+    check += (U64)json_i64(json_get(object, keys[(i * 2654435761u) % n]));
+    if(i + 1 == walks) {
+      AssertAlways(check == sum);
+    }
+  }
+  bench_end(b, r);
+  b->sink += sum + check;
+  arena_scratch_end(s);
+}
+
+/* a flat array on its own default arena, so the tape outgrows the first
+   block and has to move; the copies it leaves behind have to stay linear */
+internal Nothing
+bench_json_flat(Bench* b) {
+  U64 n = b->quick ? Million(2) : Million(8);
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U8* text = arena_push_array_no_zero(b->arena, U8, n * 2 + 1);
+  text[0] = '[';
+  for(U64 i = 0; i < n; ++i) {
+    text[i * 2 + 1] = '0';
+    text[i * 2 + 2] = i + 1 < n ? ',' : ']';
+  }
+  Str8 source = str8_raw(text, n * 2 + 1);
+
+  Arena* a = arena_alloc();
+  BenchResult r = {"json", "json_parse", "parse", "flat-default-arena", 0,
+                   source.size, 1, source.size
+                  };
+  bench_begin(b);
+  JsonValue* root = json_root(json_parse(a, source));
+  bench_end(b, r);
+  AssertAlways(root && root->count == n);
+  AssertAlways(arena_get_position(a) < 4 * (n + 1) * sizeof(JsonValue) + MB(256));
+  arena_release(a);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_json(Bench* b) {
+  bench_json_parse(b);
+  bench_json_flat(b);
+  bench_json_lookup(b);
+}
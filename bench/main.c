@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#define SEPI_PLATFORM_IMPLEMENTATION
+#define SEPI_STRING_IMPLEMENTATION
+#define SEPI_ARENA_IMPLEMENTATION
+#define SEPI_HASH_IMPLEMENTATION
+#define SEPI_HASHMAP_IMPLEMENTATION
+#define SEPI_POOL_IMPLEMENTATION
+#define SEPI_CACHE_IMPLEMENTATION
+#define SEPI_INTERN_IMPLEMENTATION
+#define SEPI_HAMT_IMPLEMENTATION
+#define SEPI_FILTER_IMPLEMENTATION
+#define SEPI_UNICODE_IMPLEMENTATION
+#define SEPI_SEARCH_IMPLEMENTATION
+#define SEPI_JSON_IMPLEMENTATION
+#define SEPI_CSV_IMPLEMENTATION
+#define SEPI_IO_IMPLEMENTATION
+#define STB_DS_IMPLEMENTATION
+
+#include "../deps/sepi/hashmap.h"
+#include "../deps/sepi/cache.h"
+#include "../deps/sepi/intern.h"
+#include "../deps/sepi/hamt.h"
+#include "../deps/sepi/filter.h"
+#include "../deps/sepi/unicode.h"
+#include "../deps/sepi/search.h"
+#include "../deps/sepi/json.h"
+#include "../deps/sepi/csv.h"
+#include "../deps/sepi/io.h"
+#include "../deps/stb/stb_ds.h"
+#include "bench.h"
+
+#include "hash.c"
+#include "hashmap.c"
+#include "cache.c"
+#include "intern.c"
+#include "hamt.c"
+#include "filter.c"
+#include "string.c"
+#include "unicode.c"
+#include "search.c"
+#include "json.c"
+#include "csv.c"
+#include "io.c"
+
+internal BenchSuite bench_suites[] = {
+  {"hash", bench_hash},
+  {"hashmap", bench_hashmap},
+  {"cache", bench_cache},
+  {"intern", bench_intern},
+  {"hamt", bench_hamt},
+  {"filter", bench_filter},
+  {"string", bench_string},
+  {"unicode", bench_unicode},
+  {"search", bench_search},
+  {"json", bench_json},
+  {"csv", bench_csv},
+  {"io", bench_io},
+};
+
+internal Nothing
+bench_usage(CStr exe) {
+  printf("usage: %s [suite...] [--quick] [--max-keys N] [--csv FILE]\n", exe);
+  printf("suites:");
+  for(U64 i = 0; i < ArrayCount(bench_suites); ++i) {
+    printf(" %s", bench_suites[i].name);
+  }
+  printf("\n");
+}
+
+int
+main(int argc, char** argv) {
+  Bench b = {0};
+  CStr selected[ArrayCount(bench_suites)] = {0};
+  U64 selected_count = 0;
+
+  b.max_keys = Million(1);
+  b.rng = 1987;
+
+  for(int i = 1; i < argc; ++i) {
+    Str8 arg = str8(argv[i]);
+    if(str8_cmp(arg, str8("--quick"), 0)) {
+      b.quick = TRUE;
+      b.max_keys = Min(b.max_keys, Thousand(10));
+    } else if(str8_cmp(arg, str8("--max-keys"), 0) && i + 1 < argc) {
+      b.max_keys = strtoull(argv[++i], 0, 10);
+    } else if(str8_cmp(arg, str8("--csv"), 0) && i + 1 < argc) {
+      CStr path = argv[++i];
+      b.csv = str8_cmp(str8(path), str8("-"), 0) ? stdout : fopen(path, "w");
+      if(!b.csv) {
+        fprintf(stderr, "cannot open '%s'\n", path);
+        return 1;
+      }
+    } else if(arg.size && arg.cstr[0] != '-' && selected_count < ArrayCount(selected)) {
+      selected[selected_count++] = arg.cstr;
+    } else {
+      bench_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  b.arena = arena_alloc(.requested_reserve_size = GB(1),
+                        .requested_commit_size = MB(64));
+  bench_perf_open(&b);
+  bench_csv_header(&b);
+
+  for(U64 i = 0; i < ArrayCount(bench_suites); ++i) {
+    Bool run = selected_count == 0;
+    for(U64 j = 0; j < selected_count; ++j) {
+      run |= str8_cmp(str8(selected[j]), str8(bench_suites[i].name), 0);
+    }
+    if(run) {
+      bench_suites[i].run(&b);
+    }
+  }
+
+  if(b.csv && b.csv != stdout) {
+    fclose(b.csv);
+  }
+  arena_release(b.arena);
+  return 0;
+}
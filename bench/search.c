@@ -0,0 +1,235 @@
+/* ===================================================== */
+/*                      SEARCH SUITE                     */
+/* ===================================================== */
+
+internal CStr bench_search_needles[] = {
+  "Content-Type", "node_modules/sepi", "x86_64,Release", "CMakeLists.txt\n",
+  "Program Files/textures", "missing-needle",
+};
+
+internal U64 bench_search_pattern_counts[] = {8, 64, 512};
+
+/* the string suite's text, NUL-terminated for the libc baselines, with a
+   ';' or '#' dropped in every few hundred bytes */
+internal Str8
+bench_search_text(Bench* b, U64 size) {
+  Str8 text = bench_string_text(b, size + 1);
+  U8* bytes = (U8*)text.cstr;
+  for(U64 at = bench_rand(b) % 512; at < size; at += 1 + bench_rand(b) % 512) {
+    bytes[at] = bench_rand(b) & 1 ? ';' : '#';
+  }
+  bytes[size] = 0;
+  return str8_raw(bytes, size);
+}
+
+/* slices of the text, so every pattern shows up somewhere */
+internal Str8*
+bench_search_patterns(Bench* b, Str8 text, U64 count) {
+  Str8* patterns = arena_push_array_no_zero(b->arena, Str8, count);
+  for(U64 p = 0; p < count; ++p) {
+    U64 size = 4 + bench_rand(b) % 9;
+    U64 at = bench_rand(b) % (text.size - size);
+    patterns[p] = str8_raw((U8*)text.cstr + at, size);
+  }
+  return patterns;
+}
+
+internal U64
+bench_search_count_scalar(Str8 text, Str8 needle, StringCompareFlags flags) {
+  U64 count = 0;
+  for(U64 i = 0; i + needle.size <= text.size; ++i) {
+    count += bench_string_cmp_scalar(str8_raw((U8*)text.cstr + i, needle.size),
+                                     needle, flags);
+  }
+  return count;
+}
+
+internal Nothing
+bench_search_find(Bench* b, Str8 text) {
+  U64 rounds = b->quick ? 2 : 8;
+  StringCompareFlags flags[] = {0, StringCompareFlag_CaseInsensitive};
+  CStr variants[] = {"exact", "nocase"};
+
+  for(U64 ni = 0; ni < ArrayCount(bench_search_needles); ++ni) {
+    Str8 needle = str8(bench_search_needles[ni]);
+    U64 count = 0;
+    BenchResult r = {"search", "strstr", "find", "exact", needle.size, text.size,
+                     0, rounds * text.size
+                    };
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(CStr at = strstr(text.cstr, needle.cstr); at; at = strstr(at + 1, needle.cstr)) {
+        count += 1;
+      }
+    }
+    r.ops = Max(count, rounds);
+    bench_end(b, r);
+
+    for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+      U64 check = 0;
+      r.structure = "str8_find";
+      r.variant = variants[fi];
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        for(U64 at = str8_find(text, 0, needle, flags[fi]); at < text.size;
+            at = str8_find(text, at + 1, needle, flags[fi])) {
+          check += 1;
+        }
+      }
+      bench_end(b, r);
+      if(flags[fi] == 0) {
+        AssertAlways(check == count);
+      } else if(ni == 0) {
+        AssertAlways(check == rounds * bench_search_count_scalar(text, needle, flags[fi]));
+      }
+    }
+  }
+}
+
+internal Nothing
+bench_search_any(Bench* b, Str8 text) {
+  U64 rounds = b->quick ? 2 : 8;
+  CStr sets[] = {";", ";#", ";#=@!?"};
+
+  for(U64 si = 0; si < ArrayCount(sets); ++si) {
+    Str8 set = str8(sets[si]);
+    U64 count = 0;
+    BenchResult r = {"search", "strcspn", "find_any", 0, set.size, text.size, 0,
+                     rounds * text.size
+                    };
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(U64 at = strcspn(text.cstr, set.cstr); at < text.size;
+          at += 1 + strcspn(text.cstr + at + 1, set.cstr)) {
+        count += 1;
+      }
+    }
+    r.ops = count;
+    bench_end(b, r);
+
+    U64 check = 0;
+    Str8ByteSet bytes = str8_byte_set(set, 0);
+    r.structure = "str8_find_any";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(U64 at = str8_find_byte_set(text, 0, &bytes); at < text.size;
+          at = str8_find_byte_set(text, at + 1, &bytes)) {
+        check += 1;
+      }
+    }
+    bench_end(b, r);
+    AssertAlways(check == count);
+  }
+}
+
+internal Nothing
+bench_search_many(Bench* b, Str8 text) {
+  StringCompareFlags flags[] = {0, StringCompareFlag_CaseInsensitive};
+  CStr variants[] = {"exact", "nocase"};
+
+  for(U64 ci = 0; ci < ArrayCount(bench_search_pattern_counts); ++ci) {
+    U64 count = bench_search_pattern_counts[ci];
+    Str8* patterns = bench_search_patterns(b, text, count);
+    for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+      ArenaScratch s = arena_scratch_begin(b->arena);
+      BenchResult r = {"search", "search_build", "build", variants[fi], 0,
+                       count, 1, 0
+                      };
+      bench_begin(b);
+      SearchAutomaton* ac = search_build(b->arena, patterns, count, flags[fi]);
+      bench_end(b, r);
+
+      /* one pass per pattern stops being worth timing past a few dozen */
+      U64 matches = 0;
+      if(count <= 64) {
+        r = (BenchResult) {
+          "search", "str8_find", "many", variants[fi], 0, count, 0, count * text.size
+        };
+        bench_begin(b);
+        for(U64 p = 0; p < count; ++p) {
+          for(U64 at = str8_find(text, 0, patterns[p], flags[fi]); at < text.size;
+              at = str8_find(text, at + 1, patterns[p], flags[fi])) {
+            matches += 1;
+          }
+        }
+        r.ops = matches;
+        bench_end(b, r);
+      }
+
+      U64 check = 0;
+      r = (BenchResult) {
+        "search", "search_count", "many", variants[fi], 0, count, 0, text.size
+      };
+      bench_begin(b);
+      check = search_count(ac, text);
+      r.ops = check;
+      bench_end(b, r);
+      AssertAlways(count > 64 || check == matches);
+
+      U64 iterated = 0;
+      r.structure = "search_next";
+      bench_begin(b);
+      SearchIter it = search_iter(ac, text);
+      SearchMatch match;
+      while(search_next(&it, &match)) {
+        b->sink += match.offset;
+        iterated += 1;
+      }
+      bench_end(b, r);
+      AssertAlways(iterated == check);
+      arena_scratch_end(s);
+    }
+  }
+}
+
+/* binary haystack and patterns that use every byte value, so the
+   automaton needs all 257 classes */
+internal Nothing
+bench_search_bytes(Bench* b, U64 size) {
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U8* bytes = arena_push_array_no_zero(b->arena, U8, size);
+  for(U64 i = 0; i < size; ++i) {
+    bytes[i] = (U8)bench_rand(b);
+  }
+  Str8 text = str8_raw(bytes, size);
+
+  U8 pairs[512];
+  Str8 patterns[256];
+  for(U32 p = 0; p < 256; ++p) {
+    pairs[p * 2] = (U8)p;
+    pairs[p * 2 + 1] = (U8)(p * 7 + 1);
+    patterns[p] = str8_raw(pairs + p * 2, 2);
+  }
+
+  BenchResult r = {"search", "search_build", "build", "bytes", 0, 256, 1, 0};
+  bench_begin(b);
+  SearchAutomaton* ac = search_build(b->arena, patterns, 256, 0);
+  bench_end(b, r);
+  AssertAlways(ac->class_count == 257);
+
+  r = (BenchResult) {
+    "search", "search_count", "many", "bytes", 0, 256, 0, text.size
+  };
+  bench_begin(b);
+  U64 check = search_count(ac, text);
+  r.ops = check;
+  bench_end(b, r);
+
+  U64 matches = 0;
+  for(U64 i = 0; i + 1 < text.size; ++i) {
+    matches += bytes[i + 1] == (U8)(bytes[i] * 7 + 1);
+  }
+  AssertAlways(check == matches);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_search(Bench* b) {
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  Str8 text = bench_search_text(b, b->quick ? MB(4) : MB(64));
+  bench_search_find(b, text);
+  bench_search_any(b, text);
+  bench_search_many(b, str8_raw((U8*)text.cstr, Min(text.size, MB(16))));
+  bench_search_bytes(b, b->quick ? MB(1) : MB(16));
+  arena_scratch_end(s);
+}
@@ -0,0 +1,466 @@
+/* ===================================================== */
+/*                      STRING SUITE                     */
+/* ===================================================== */
+
+#define BENCH_STRING_PAIRS 4096
+#define BENCH_STRING_VALUES 4096
+
+internal CStr bench_string_segments[] = {
+  "usr", "local", "include", "Program Files", "src", "deps", "sepi",
+  "string.h", "node_modules", "Documents", "build", "Release", "x86_64",
+  "Content-Type", "assets", "textures", "README.md", "CMakeLists.txt",
+};
+
+internal U64 bench_string_sizes[] = {16, 32, 64, 128, 256};
+
+/* the byte loop str8_cmp used before the vector kernels */
+internal Bool
+bench_string_cmp_scalar(Str8 a, Str8 b, StringCompareFlags flags) {
+  Bool result = FALSE;
+  if(a.size == b.size || (flags & StringCompareFlag_RightSideSloppy)) {
+    U64 size = Min(a.size, b.size);
+    result = 1;
+    for(U64 i = 0; i < size; i += 1) {
+      U8 at = a.cstr[i];
+      U8 bt = b.cstr[i];
+      if(flags & StringCompareFlag_CaseInsensitive) {
+        at = to_upper_char(at);
+        bt = to_upper_char(bt);
+      }
+      if(flags & StringCompareFlag_SlashInsensitive) {
+        at = correct_slash_from_char(at);
+        bt = correct_slash_from_char(bt);
+      }
+      if(at != bt) {
+        result = 0;
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+/* paths of `size` bytes and a copy of each with case (and slashes when
+   `flags` ask for it) flipped at random, so every pair matches and gets
+   scanned to the end */
+internal Nothing
+bench_string_paths(Bench* b, U64 size, StringCompareFlags flags, Str8* left,
+                   Str8* right) {
+  for(U64 i = 0; i < BENCH_STRING_PAIRS; ++i) {
+    U8* l = arena_push_array_no_zero(b->arena, U8, size);
+    U8* r = arena_push_array_no_zero(b->arena, U8, size);
+    U64 at = 0;
+    while(at < size) {
+      CStr segment = bench_string_segments[bench_rand(b) %
+                                           ArrayCount(bench_string_segments)];
+      l[at++] = bench_rand(b) & 1 ? '/' : '\\';
+      for(; *segment && at < size; ++segment) {
+        l[at++] = (U8)*segment;
+      }
+    }
+    for(U64 j = 0; j < size; ++j) {
+      U8 c = l[j];
+      if(bench_rand(b) & 1) {
+        c = is_upper_char(c) ? to_lower_char(c) : to_upper_char(c);
+      }
+      if((flags & StringCompareFlag_SlashInsensitive) && (bench_rand(b) & 1)) {
+        c = c == '/' ? '\\' : c == '\\' ? '/' : c;
+      }
+      r[j] = c;
+    }
+    left[i] = str8_raw(l, size);
+    right[i] = str8_raw(r, size);
+  }
+}
+
+internal Nothing
+bench_string_cmp(Bench* b) {
+  U64 total = b->quick ? Thousand(200) : Million(4);
+  StringCompareFlags flags[] = {
+    StringCompareFlag_CaseInsensitive,
+    StringCompareFlag_CaseInsensitive | StringCompareFlag_SlashInsensitive,
+  };
+  CStr variants[] = {"case", "case+slash"};
+
+  for(U64 si = 0; si < ArrayCount(bench_string_sizes); ++si) {
+    U64 size = bench_string_sizes[si];
+    U64 rounds = Max(1, total / BENCH_STRING_PAIRS);
+
+    for(U64 fi = 0; fi < ArrayCount(flags); ++fi) {
+      ArenaScratch s = arena_scratch_begin(b->arena);
+      Str8* left = arena_push_array_no_zero(b->arena, Str8, BENCH_STRING_PAIRS);
+      Str8* right = arena_push_array_no_zero(b->arena, Str8,
+                                             BENCH_STRING_PAIRS);
+      bench_string_paths(b, size, flags[fi], left, right);
+      BenchResult r = {"string", "scalar", "cmp", variants[fi], size,
+                       BENCH_STRING_PAIRS, rounds * BENCH_STRING_PAIRS,
+                       rounds * BENCH_STRING_PAIRS * size
+                      };
+      U64 matches = 0;
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        for(U64 i = 0; i < BENCH_STRING_PAIRS; ++i) {
+          matches += bench_string_cmp_scalar(left[i], right[i], flags[fi]);
+        }
+      }
+      bench_end(b, r);
+
+      r.structure = "str8_cmp";
+      bench_begin(b);
+      for(U64 round = 0; round < rounds; ++round) {
+        for(U64 i = 0; i < BENCH_STRING_PAIRS; ++i) {
+          matches += str8_cmp(left[i], right[i], flags[fi]);
+        }
+      }
+      bench_end(b, r);
+      AssertAlways(matches == 2 * rounds * BENCH_STRING_PAIRS);
+      arena_scratch_end(s);
+    }
+  }
+}
+
+/* what building strings looked like before str8f: format into a stack
+   buffer, then copy into a malloc'd one per string */
+internal CStr
+bench_string_malloc(CStr fmt, ...) {
+  char buffer[512];
+  va_list args;
+  va_start(args, fmt);
+  int size = vsnprintf(buffer, sizeof(buffer), fmt, args);
+  va_end(args);
+  char* result = malloc((Sz)size + 1);
+  MemoryCopy(result, buffer, (Sz)size + 1);
+  return result;
+}
+
+internal Nothing
+bench_string_format(Bench* b) {
+  U64 total = b->quick ? Thousand(200) : Million(4);
+  U64 rounds = Max(1, total / BENCH_STRING_VALUES);
+  U64 n = BENCH_STRING_VALUES;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  U64* ints = arena_push_array_no_zero(b->arena, U64, n);
+  F64* floats = arena_push_array_no_zero(b->arena, F64, n);
+  CStr* strings = arena_push_array_no_zero(b->arena, CStr, n);
+  for(U64 i = 0; i < n; ++i) {
+    U64 shift = bench_rand(b) % 64;
+    ints[i] = bench_rand(b) >> shift;
+    floats[i] = (F64)(bench_rand(b) % Million(100)) / 1000.0;
+  }
+  CStr ops[] = {"u64", "f64", "format"};
+
+  for(U64 oi = 0; oi < ArrayCount(ops); ++oi) {
+    BenchResult r = {"string", "snprintf", ops[oi], "malloc", 0, n,
+                     rounds * n, 0
+                    };
+    U64 bytes = 0;
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(U64 i = 0; i < n; ++i) {
+        switch(oi) {
+        case 0:
+          strings[i] = bench_string_malloc("%llu", (unsigned long long)ints[i]);
+          break;
+        case 1:
+          strings[i] = bench_string_malloc("%.3f", floats[i]);
+          break;
+        default:
+          strings[i] = bench_string_malloc("key%llu=%.3f",
+                                           (unsigned long long)ints[i],
+                                           floats[i]);
+          break;
+        }
+      }
+      for(U64 i = 0; i < n; ++i) {
+        bytes += strlen(strings[i]);
+        free((RawPtr)strings[i]);
+      }
+    }
+    r.bytes = bytes;
+    bench_end(b, r);
+
+    r.structure = oi == 2 ? "str8f" : oi == 1 ? "str8_from_f64" :
+                  "str8_from_u64";
+    r.variant = "arena";
+    U64 check = 0;
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      for(U64 i = 0; i < n; ++i) {
+        Str8 out = {0};
+        switch(oi) {
+        case 0:
+          out = str8_from_u64(b->arena, ints[i]);
+          break;
+        case 1:
+          out = str8_from_f64(b->arena, floats[i], 3);
+          break;
+        default:
+          out = str8f(b->arena, "key%llu=%.3f", (unsigned long long)ints[i],
+                      floats[i]);
+          break;
+        }
+        check += out.size;
+      }
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+    AssertAlways(check == bytes);
+  }
+
+  BenchResult r = {"string", "snprintf", "join", "realloc", 0, n, rounds * n, 0};
+  U64 bytes = 0;
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    U64 capacity = 64;
+    U64 size = 0;
+    char* joined = malloc(capacity);
+    for(U64 i = 0; i < n; ++i) {
+      char buffer[32];
+      int piece = snprintf(buffer, sizeof(buffer), "%s%llu", i ? "," : "",
+                           (unsigned long long)ints[i]);
+      while(size + (U64)piece + 1 > capacity) {
+        capacity *= 2;
+        joined = realloc(joined, capacity);
+      }
+      MemoryCopy(joined + size, buffer, (Sz)piece + 1);
+      size += (U64)piece;
+    }
+    bytes += size;
+    free(joined);
+  }
+  r.bytes = bytes;
+  bench_end(b, r);
+
+  r.structure = "str8_list";
+  r.variant = "arena";
+  U64 check = 0;
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    ArenaScratch rs = arena_scratch_begin(b->arena);
+    Str8List list = {0};
+    for(U64 i = 0; i < n; ++i) {
+      str8_list_push(b->arena, &list, str8_from_u64(b->arena, ints[i]));
+    }
+    check += str8_list_join(b->arena, &list, str8(",")).size;
+    arena_scratch_end(rs);
+  }
+  bench_end(b, r);
+  AssertAlways(check == bytes);
+  arena_scratch_end(s);
+}
+
+/* words separated by ' ' or ',' with a '\n' every few words */
+internal Str8
+bench_string_text(Bench* b, U64 size) {
+  U8* text = arena_push_array_no_zero(b->arena, U8, size);
+  U64 at = 0;
+  while(at < size) {
+    CStr segment = bench_string_segments[bench_rand(b) %
+                                         ArrayCount(bench_string_segments)];
+    for(; *segment && at < size; ++segment) {
+      text[at++] = (U8)*segment;
+    }
+    if(at < size) {
+      U64 pick = bench_rand(b) % 8;
+      text[at++] = pick == 0 ? '\n' : pick < 3 ? ',' : ' ';
+    }
+  }
+  return str8_raw(text, size);
+}
+
+/* the byte loops every caller used to write by hand */
+internal U64
+bench_string_split_scalar(Str8 text, U32 kind, U64* count) {
+  U64 sum = 0;
+  U64 start = 0;
+  Bool in_token = FALSE;
+  for(U64 i = 0; i < text.size; ++i) {
+    U8 c = (U8)text.cstr[i];
+    if(kind == Str8SplitKind_Whitespace) {
+      if(is_space_char(c)) {
+        if(in_token) {
+          sum += i - start;
+          *count += 1;
+        }
+        in_token = FALSE;
+      } else if(!in_token) {
+        in_token = TRUE;
+        start = i;
+      }
+    } else if(c == (kind == Str8SplitKind_Lines ? '\n' : ',')) {
+      sum += i - start;
+      *count += 1;
+      start = i + 1;
+    }
+  }
+  if(start < text.size && (kind != Str8SplitKind_Whitespace || in_token)) {
+    sum += text.size - start;
+    *count += 1;
+  }
+  return sum;
+}
+
+internal Str8Split
+bench_string_splitter(Str8 text, U32 kind) {
+  Str8Split it = {0};
+  if(kind == Str8SplitKind_Lines) {
+    it = str8_split_lines(text);
+  } else if(kind == Str8SplitKind_Whitespace) {
+    it = str8_split_whitespace(text);
+  } else {
+    it = str8_split(text, ',', Str8SplitFlag_SkipEmpty);
+  }
+  return it;
+}
+
+internal Nothing
+bench_string_split(Bench* b) {
+  U64 size = b->quick ? MB(4) : MB(64);
+  U64 rounds = b->quick ? 2 : 4;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  Str8 text = bench_string_text(b, size);
+  U32 kinds[] = {
+    Str8SplitKind_Delimiter, Str8SplitKind_Lines, Str8SplitKind_Whitespace,
+  };
+  CStr ops[] = {"split", "lines", "whitespace"};
+
+  for(U64 ki = 0; ki < ArrayCount(kinds); ++ki) {
+    U64 count = 0;
+    U64 sum = 0;
+    BenchResult r = {"string", "scalar", ops[ki], "loop", 0, size, 0,
+                     rounds * size
+                    };
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      sum += bench_string_split_scalar(text, kinds[ki], &count);
+    }
+    r.ops = count;
+    bench_end(b, r);
+
+    U64 check_count = 0;
+    U64 check_sum = 0;
+    r.structure = "str8_split";
+    r.variant = "iter";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      Str8Split it = bench_string_splitter(text, kinds[ki]);
+      Str8 field;
+      while(str8_split_next(&it, &field)) {
+        check_sum += field.size;
+        check_count += 1;
+      }
+    }
+    bench_end(b, r);
+    AssertAlways(check_count == count && check_sum == sum);
+
+    check_count = 0;
+    r.variant = "all";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      check_count += str8_split_all(b->arena,
+                                    bench_string_splitter(text, kinds[ki])).count;
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+    AssertAlways(check_count == count);
+  }
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_string_parse(Bench* b) {
+  U64 total = b->quick ? Thousand(200) : Million(4);
+  U64 rounds = Max(1, total / BENCH_STRING_VALUES);
+  U64 n = BENCH_STRING_VALUES;
+  ArenaScratch s = arena_scratch_begin(b->arena);
+  Str8* ints = arena_push_array_no_zero(b->arena, Str8, n);
+  Str8* hexes = arena_push_array_no_zero(b->arena, Str8, n);
+  Str8* floats = arena_push_array_no_zero(b->arena, Str8, n);
+  U64 int_bytes = 0;
+  U64 hex_bytes = 0;
+  U64 float_bytes = 0;
+  for(U64 i = 0; i < n; ++i) {
+    U64 shift = bench_rand(b) % 64;
+    U64 value = bench_rand(b) >> shift;
+    ints[i] = str8_from_u64(b->arena, value);
+    hexes[i] = str8f(b->arena, "%llx", (unsigned long long)value);
+    U64 bits = bench_rand(b);
+    F64 f = (F64)(bits >> 11) / (F64)(1ull << (bits % 64));
+    floats[i] = bits & 1 ? str8f(b->arena, "%.17g", f) :
+                str8_from_f64(b->arena, f, 3);
+    int_bytes += ints[i].size;
+    hex_bytes += hexes[i].size;
+    float_bytes += floats[i].size;
+  }
+
+  for(U32 hex = 0; hex < 2; ++hex) {
+    Str8* strings = hex ? hexes : ints;
+    U32 base = hex ? 16 : 10;
+    BenchResult r = {"string", "strtoull", "u64", hex ? "hex" : "dec", 0, n,
+                     rounds * n, rounds * (hex ? hex_bytes : int_bytes)
+                    };
+    U64 sum = 0;
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(U64 i = 0; i < n; ++i) {
+        sum += strtoull(strings[i].cstr, 0, (int)base);
+      }
+    }
+    bench_end(b, r);
+
+    U64 check = 0;
+    r.structure = "str8_to_u64";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      for(U64 i = 0; i < n; ++i) {
+        U64 value = 0;
+        str8_to_u64(strings[i], base, &value);
+        check += value;
+      }
+    }
+    bench_end(b, r);
+    AssertAlways(check == sum);
+  }
+
+  BenchResult r = {"string", "strtod", "f64", "mixed", 0, n, rounds * n,
+                   rounds * float_bytes
+                  };
+  U64 mismatches = 0;
+  F64 sum = 0;
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    for(U64 i = 0; i < n; ++i) {
+      sum += strtod(floats[i].cstr, 0);
+    }
+  }
+  bench_end(b, r);
+
+  F64 check = 0;
+  r.structure = "str8_to_f64";
+  bench_begin(b);
+  for(U64 round = 0; round < rounds; ++round) {
+    for(U64 i = 0; i < n; ++i) {
+      F64 value = 0;
+      str8_to_f64(floats[i], &value);
+      check += value;
+    }
+  }
+  bench_end(b, r);
+  for(U64 i = 0; i < n; ++i) {
+    F64 value = 0;
+    str8_to_f64(floats[i], &value);
+    mismatches += value != strtod(floats[i].cstr, 0);
+  }
+  AssertAlways(mismatches == 0 && check == sum);
+  arena_scratch_end(s);
+}
+
+internal Nothing
+bench_string(Bench* b) {
+  bench_string_cmp(b);
+  bench_string_format(b);
+  bench_string_split(b);
+  bench_string_parse(b);
+}
@@ -0,0 +1,154 @@
+/* ===================================================== */
+/*                     UNICODE SUITE                     */
+/* ===================================================== */
+
+/* code point ranges each corpus draws from, picked by weight out of 8 */
+typedef struct BenchUnicodeCorpus BenchUnicodeCorpus;
+struct BenchUnicodeCorpus {
+  CStr name;
+  U32 ascii;
+  U32 two;
+  U32 three;
+  U32 four;
+};
+
+internal BenchUnicodeCorpus bench_unicode_corpora[] = {
+  {"ascii", 8, 0, 0, 0},
+  {"latin", 6, 2, 0, 0},
+  {"cyrillic", 2, 6, 0, 0},
+  {"cjk", 1, 0, 7, 0},
+  {"emoji", 4, 0, 1, 3},
+  {"mixed", 2, 2, 2, 2},
+};
+
+internal Str8
+bench_unicode_text(Bench* b, BenchUnicodeCorpus* c, U64 size) {
+  U8* text = arena_push_array_no_zero(b->arena, U8, size);
+  U64 at = 0;
+  while(at < size) {
+    U32 pick = (U32)(bench_rand(b) % 8);
+    U32 codepoint = 0;
+    if(pick < c->ascii) {
+      codepoint = 0x20 + (U32)(bench_rand(b) % 0x5F);
+    } else if(pick < c->ascii + c->two) {
+      codepoint = 0xC0 + (U32)(bench_rand(b) % 0x400);
+    } else if(pick < c->ascii + c->two + c->three) {
+      codepoint = 0x4E00 + (U32)(bench_rand(b) % 0x5000);
+    } else {
+      codepoint = 0x1F300 + (U32)(bench_rand(b) % 0x300);
+    }
+    U8 encoded[4];
+    U32 inc = utf8_encode(encoded, codepoint);
+    if(at + inc > size) {
+      break;
+    }
+    MemoryCopy(text + at, encoded, inc);
+    at += inc;
+  }
+  for(; at < size; ++at) {
+    text[at] = ' ';
+  }
+  return str8_raw(text, size);
+}
+
+/* the per-code-point loop we validated input with before */
+internal Bool
+bench_unicode_validate_scalar(Str8 s) {
+  const U8* p = (const U8*)s.cstr;
+  U64 at = 0;
+  while(at < s.size) {
+    UnicodeDecode d = utf8_decode(p + at, s.size - at);
+    if(d.codepoint == UNICODE_REPLACEMENT) {
+      break;
+    }
+    at += d.inc;
+  }
+  return at == s.size;
+}
+
+internal Nothing
+bench_unicode(Bench* b) {
+  U64 size = b->quick ? MB(1) : MB(32);
+  U64 rounds = b->quick ? 2 : 4;
+
+  for(U64 ci = 0; ci < ArrayCount(bench_unicode_corpora); ++ci) {
+    BenchUnicodeCorpus* c = &bench_unicode_corpora[ci];
+    ArenaScratch s = arena_scratch_begin(b->arena);
+    Str8 text = bench_unicode_text(b, c, size);
+    BenchResult r = {"unicode", "scalar", "validate", c->name, 0, size,
+                     rounds, rounds * size
+                    };
+    U64 valid = 0;
+
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      valid += bench_unicode_validate_scalar(text);
+    }
+    bench_end(b, r);
+
+    r.structure = "utf8_validate";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      valid += utf8_validate(text);
+    }
+    bench_end(b, r);
+
+    r.structure = "utf8_valid_size";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      valid += utf8_valid_size(text) == text.size;
+    }
+    bench_end(b, r);
+    AssertAlways(valid == 3 * rounds);
+
+    Str16 wide = {0};
+    Str32 full = {0};
+    r.structure = "str16_from_8";
+    r.op = "transcode";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      wide = str16_from_8(b->arena, text);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+
+    r.structure = "str32_from_8";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      full = str32_from_8(b->arena, text);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+
+    wide = str16_from_8(b->arena, text);
+    full = str32_from_8(b->arena, text);
+    Str8 back = {0};
+    r.structure = "str8_from_16";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      back = str8_from_16(b->arena, wide);
+      AssertAlways(back.size == text.size);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+
+    r.structure = "str8_from_32";
+    bench_begin(b);
+    for(U64 round = 0; round < rounds; ++round) {
+      ArenaScratch rs = arena_scratch_begin(b->arena);
+      back = str8_from_32(b->arena, full);
+      AssertAlways(back.size == text.size);
+      arena_scratch_end(rs);
+    }
+    bench_end(b, r);
+
+    back = str8_from_16(b->arena, wide);
+    AssertAlways(IsMemoryEq(back.cstr, text.cstr, text.size));
+    back = str8_from_32(b->arena, full);
+    AssertAlways(IsMemoryEq(back.cstr, text.cstr, text.size));
+    arena_scratch_end(s);
+  }
+}
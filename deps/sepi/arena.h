@@ -69,8 +69,8 @@ MODULE ArenaScratch arena_scratch_begin(Arena* a);
 MODULE Nothing arena_scratch_end(ArenaScratch s);
 
 #define arena_alloc(...) arena_alloc_(&(ArenaParams){.requested_reserve_size = ARENA_DEFAULT_RESERVE_SIZE, .requested_commit_size = ARENA_DEFAULT_COMMIT_SIZE, .caller_file_name = __FILE__, .caller_file_line = __LINE__, __VA_ARGS__})
-#define arena_push_array_no_zero_aligned(arena, type, count, alignment) (type *)arena_push((arena), sizeof(type) * (count), (alignment), (TRUE))
-#define arena_push_array_aligned(arena, type, count, alignment) (type *)arena_push((arena), sizeof(type) * (count), (alignment), (FALSE))
+#define arena_push_array_no_zero_aligned(arena, type, count, alignment) (type *)arena_push((arena), sizeof(type) * (count), (alignment), (FALSE))
+#define arena_push_array_aligned(arena, type, count, alignment) (type *)arena_push((arena), sizeof(type) * (count), (alignment), (TRUE))
 #define arena_push_array_no_zero(arena, type, count) arena_push_array_no_zero_aligned(arena, type, count, Max(8, AlignOf(type)))
 #define arena_push_array(arena, type, count) arena_push_array_aligned(arena, type, count, Max(8, AlignOf(type)))
 
@@ -124,6 +124,8 @@ arena_release(Arena* a) {
   for(Arena* it = a->current_block, *previous_block = 0; it != 0;
       it = previous_block) {
     previous_block = it->previous_block;
+    /* the next reservation may land on the same pages */
+    AsanUnpoisonMemoryRegion(it, it->reserved_size);
     platform_release(it, it->reserved_size);
   }
 }
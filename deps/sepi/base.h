@@ -136,11 +136,23 @@ void __asan_unpoison_memory_region(void const volatile* addr, size_t size);
 # define AsanUnpoisonMemoryRegion(addr, size) ((void)(addr), (void)(size))
 #endif /* DEBUG_MODE */
 
+#if CC_GCC || CC_CLANG
+#define Prefetch(addr) __builtin_prefetch((addr))
+#define FORCE_INLINE inline __attribute__((always_inline))
+#elif CC_MSVC
+#define Prefetch(addr) ((void)(addr))
+#define FORCE_INLINE __forceinline
+#else
+#define Prefetch(addr) ((void)(addr))
+#define FORCE_INLINE inline
+#endif
+
 #define MemZero(s,z) memset((s),0,(z))
 #define MemZeroStruct(s) MemZero((s),sizeof(*(s)))
 #define MemZeroArray(a) MemZero((a),sizeof(a))
 #define MemZeroTyped(m,c) MemZero((m),sizeof(*(m))*(c))
 
+#define MemoryCopy(d, s, size) memcpy((d), (s), (size))
 #define MemoryCompare(a, b, size) memcmp((a), (b), (size))
 #define IsMemoryEq(a,b,z) (MemoryCompare((a),(b),(z)) == 0)
 #define IsStructEq(a,b) IsMemoryEq((a),(b),sizeof(*(a)))
@@ -165,6 +177,7 @@ void __asan_unpoison_memory_region(void const volatile* addr, size_t size);
 /* GENERAL */
 #define noop ((void)0)
 #define Ignore(_V) ((void)(_V))
+#define ArrayCount(a) (sizeof(a) / sizeof((a)[0]))
 
 /* MATH MACROS */
 #define IsPow2(X) ((X) != 0 && ((X) & ((X) -1 )) ==0 )
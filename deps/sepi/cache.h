@@ -0,0 +1,413 @@
+#ifndef SEPI_CACHE_H
+#define SEPI_CACHE_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "platform.h"
+#include "arena.h"
+#include "pool.h"
+#include "hashmap.h"
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_CACHE_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_CACHE_IMPLEMENTATION */
+
+#define CACHE_DEFAULT_MAX_ENTRIES 1024
+#define CACHE_DEFAULT_MAX_KEY_SIZE 64
+#define CACHE_KEY_MIN_CLASS 4
+#define CACHE_KEY_CLASSES 64
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+typedef U32 CachePolicy;
+enum {
+  CachePolicy_LRU,
+  CachePolicy_Clock,
+};
+
+typedef Nothing (*CacheEvictFn)(HashMapKV* kv, RawPtr user);
+
+typedef struct CacheParams CacheParams;
+struct CacheParams {
+  U64 max_entries;
+  U64 max_bytes;
+  U64 max_key_size;
+  CachePolicy policy;
+  CacheEvictFn on_evict;
+  RawPtr user;
+};
+
+/* the key bytes live in a separate pool slot of the next power of two size */
+typedef struct CacheEntry CacheEntry;
+struct CacheEntry {
+  CacheEntry* prev;
+  CacheEntry* next;
+  HashMapKV kv;
+  U64 bytes;
+  Bool referenced;
+};
+
+/* `ring` is the most recently used entry for LRU and the hand for CLOCK */
+typedef struct Cache Cache;
+struct Cache {
+  CacheParams params;
+  HashMap* index;
+  Pool* entries;
+  Pool* keys[CACHE_KEY_CLASSES];
+  Arena* arena;
+  CacheEntry* ring;
+  U64 count;
+  U64 bytes;
+  U64 hits;
+  U64 misses;
+  U64 evictions;
+};
+
+typedef struct CacheShard CacheShard;
+struct CacheShard {
+  PlatformMutex lock;
+  Arena* arena;
+  Cache* cache;
+};
+
+typedef struct CacheSharded CacheSharded;
+struct CacheSharded {
+  U64 shard_count;
+  CacheShard* shards;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE Cache* cache_init_(Arena* a, CacheParams* params);
+MODULE HashMapKV* cache_get(Cache* c, Str8 key);
+MODULE HashMapKV* cache_put(Cache* c, Str8 key, U64 bytes);
+MODULE HashMapKV* cache_put_str8(Cache* c, Str8 key, Str8 value, U64 bytes);
+MODULE HashMapKV* cache_put_rawptr(Cache* c, Str8 key, RawPtr value,
+                                   U64 bytes);
+MODULE HashMapKV* cache_put_u64(Cache* c, Str8 key, U64 value, U64 bytes);
+MODULE Bool cache_remove(Cache* c, Str8 key, HashMapKV* out);
+MODULE Bool cache_evict(Cache* c);
+MODULE CacheSharded* cache_sharded_init_(Arena* a, U64 shard_count,
+                                         CacheParams* params);
+MODULE Nothing cache_sharded_release(CacheSharded* cs);
+MODULE Bool cache_sharded_get(CacheSharded* cs, Str8 key, HashMapKV* out);
+MODULE Bool cache_sharded_put(CacheSharded* cs, Str8 key, HashMapKV value,
+                              U64 bytes);
+MODULE Bool cache_sharded_remove(CacheSharded* cs, Str8 key, HashMapKV* out);
+
+/* keys longer than `max_key_size` and entries whose `bytes` plus key size
+   exceed a nonzero `max_bytes` are rejected: the put returns 0 and the cache
+   is left untouched */
+#define CACHE_PARAMS(...) &(CacheParams){.max_entries = CACHE_DEFAULT_MAX_ENTRIES, .max_key_size = CACHE_DEFAULT_MAX_KEY_SIZE, .policy = CachePolicy_LRU, __VA_ARGS__}
+#define cache_init(arena, ...) cache_init_((arena), CACHE_PARAMS(__VA_ARGS__))
+#define cache_sharded_init(arena, shards, ...) cache_sharded_init_((arena), (shards), CACHE_PARAMS(__VA_ARGS__))
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_CACHE_IMPLEMENTATION
+
+MODULE Nothing
+cache_ring_insert_before(CacheEntry* at, CacheEntry* e) {
+  e->next = at;
+  e->prev = at->prev;
+  at->prev->next = e;
+  at->prev = e;
+}
+
+MODULE Nothing
+cache_ring_unlink(Cache* c, CacheEntry* e) {
+  if(e->next == e) {
+    c->ring = 0;
+  } else {
+    if(c->ring == e) {
+      c->ring = e->next;
+    }
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+  }
+  e->prev = e->next = 0;
+}
+
+MODULE Nothing
+cache_ring_link(Cache* c, CacheEntry* e) {
+  if(c->ring == 0) {
+    e->prev = e->next = e;
+    c->ring = e;
+  } else {
+    cache_ring_insert_before(c->ring, e);
+    if(c->params.policy == CachePolicy_LRU) {
+      c->ring = e;
+    }
+  }
+}
+
+MODULE Nothing
+cache_touch(Cache* c, CacheEntry* e) {
+  if(c->params.policy == CachePolicy_LRU) {
+    if(c->ring != e) {
+      cache_ring_unlink(c, e);
+      cache_ring_link(c, e);
+    }
+  } else {
+    e->referenced = TRUE;
+  }
+}
+
+MODULE CacheEntry*
+cache_victim(Cache* c) {
+  CacheEntry* e = c->ring;
+  if(e && c->params.policy == CachePolicy_LRU) {
+    e = e->prev;
+  } else if(e) {
+    while(e->referenced) {
+      e->referenced = FALSE;
+      e = e->next;
+    }
+    c->ring = e;
+  }
+  return e;
+}
+
+MODULE U64
+cache_key_class(U64 size) {
+  U64 bits = size > 1 ? 64 - (U64)__builtin_clzll(size - 1) : 0;
+  return Max(bits, CACHE_KEY_MIN_CLASS);
+}
+
+MODULE Str8
+cache_key_push(Cache* c, Str8 key) {
+  U64 class = cache_key_class(key.size);
+  if(c->keys[class] == 0) {
+    c->keys[class] = pool_init(c->arena, 1ull << class, 8);
+  }
+  U8* copy = (U8*)pool_push(c->keys[class], FALSE);
+  MemoryCopy(copy, key.cstr, key.size);
+  return str8_raw(copy, key.size);
+}
+
+MODULE Nothing
+cache_key_pop(Cache* c, Str8 key) {
+  pool_pop(c->keys[cache_key_class(key.size)], (RawPtr)key.cstr);
+}
+
+MODULE Nothing
+cache_drop(Cache* c, CacheEntry* e) {
+  cache_ring_unlink(c, e);
+  hashmap_pop(c->index, e->kv.k_str);
+  c->count -= 1;
+  c->bytes -= e->bytes;
+  cache_key_pop(c, e->kv.k_str);
+  pool_pop(c->entries, e);
+}
+
+MODULE Cache*
+cache_init_(Arena* a, CacheParams* params) {
+  Cache* c = arena_push_array(a, Cache, 1);
+  c->params = *params;
+  c->arena = a;
+  c->index = hashmap_init(a, params->max_entries ? params->max_entries
+                          : CACHE_DEFAULT_MAX_ENTRIES);
+  c->entries = pool_init_typed(a, CacheEntry);
+  return c;
+}
+
+MODULE Bool
+cache_evict(Cache* c) {
+  CacheEntry* e = cache_victim(c);
+  if(e == 0) {
+    return FALSE;
+  }
+  if(c->params.on_evict) {
+    c->params.on_evict(&e->kv, c->params.user);
+  }
+  c->evictions += 1;
+  cache_drop(c, e);
+  return TRUE;
+}
+
+MODULE HashMapKV*
+cache_get(Cache* c, Str8 key) {
+  HashMapKV* slot = hashmap_find(c->index, key);
+  if(slot == 0) {
+    c->misses += 1;
+    return 0;
+  }
+  CacheEntry* e = (CacheEntry*)slot->v_rawptr;
+  cache_touch(c, e);
+  c->hits += 1;
+  return &e->kv;
+}
+
+MODULE HashMapKV*
+cache_put(Cache* c, Str8 key, U64 bytes) {
+  if(key.size > c->params.max_key_size) {
+    return 0;
+  }
+
+  bytes += key.size;
+  if(c->params.max_bytes && bytes > c->params.max_bytes) {
+    return 0;
+  }
+
+  Bool inserted = FALSE;
+  HashMapKV* slot = hashmap_get_or_insert(c->arena, c->index, key, &inserted);
+  CacheEntry* e = (CacheEntry*)slot->v_rawptr;
+
+  if(!inserted) {
+    c->bytes = c->bytes - e->bytes + bytes;
+    e->bytes = bytes;
+    cache_ring_unlink(c, e);
+  }
+
+  U64 max_entries = c->params.max_entries ? c->params.max_entries : UINT64_MAX;
+  U64 max_bytes = c->params.max_bytes ? c->params.max_bytes : UINT64_MAX;
+  U64 incoming = inserted ? bytes : 0;
+  while(c->ring &&
+        (c->count + inserted > max_entries || c->bytes + incoming > max_bytes)) {
+    cache_evict(c);
+  }
+
+  if(inserted) {
+    e = (CacheEntry*)pool_push(c->entries, TRUE);
+    e->kv.k_str = cache_key_push(c, key);
+    e->bytes = bytes;
+    slot->k_str = e->kv.k_str;
+    slot->v_rawptr = e;
+    c->count += 1;
+    c->bytes += bytes;
+  }
+
+  e->referenced = !inserted;
+  cache_ring_link(c, e);
+  return &e->kv;
+}
+
+MODULE HashMapKV*
+cache_put_str8(Cache* c, Str8 key, Str8 value, U64 bytes) {
+  HashMapKV* kv = cache_put(c, key, bytes);
+  if(kv) {
+    kv->v_str = value;
+  }
+  return kv;
+}
+
+MODULE HashMapKV*
+cache_put_rawptr(Cache* c, Str8 key, RawPtr value, U64 bytes) {
+  HashMapKV* kv = cache_put(c, key, bytes);
+  if(kv) {
+    kv->v_rawptr = value;
+  }
+  return kv;
+}
+
+MODULE HashMapKV*
+cache_put_u64(Cache* c, Str8 key, U64 value, U64 bytes) {
+  HashMapKV* kv = cache_put(c, key, bytes);
+  if(kv) {
+    kv->v_u64 = value;
+  }
+  return kv;
+}
+
+MODULE Bool
+cache_remove(Cache* c, Str8 key, HashMapKV* out) {
+  HashMapKV* slot = hashmap_find(c->index, key);
+  if(slot == 0) {
+    return FALSE;
+  }
+  CacheEntry* e = (CacheEntry*)slot->v_rawptr;
+  if(out) {
+    *out = e->kv;
+  }
+  cache_drop(c, e);
+  return TRUE;
+}
+
+MODULE CacheSharded*
+cache_sharded_init_(Arena* a, U64 shard_count, CacheParams* params) {
+  CacheSharded* cs = arena_push_array(a, CacheSharded, 1);
+  CacheParams shard_params = *params;
+  shard_count = Max(shard_count, 1);
+  shard_params.max_entries = (params->max_entries + shard_count - 1) / shard_count;
+  shard_params.max_bytes = (params->max_bytes + shard_count - 1) / shard_count;
+
+  cs->shard_count = shard_count;
+  cs->shards = arena_push_array(a, CacheShard, shard_count);
+  for(U64 i = 0; i < shard_count; ++i) {
+    CacheShard* shard = cs->shards + i;
+    platform_mutex_init(&shard->lock);
+    shard->arena = arena_alloc();
+    shard->cache = cache_init_(shard->arena, &shard_params);
+  }
+  return cs;
+}
+
+MODULE Nothing
+cache_sharded_release(CacheSharded* cs) {
+  for(U64 i = 0; i < cs->shard_count; ++i) {
+    platform_mutex_destroy(&cs->shards[i].lock);
+    arena_release(cs->shards[i].arena);
+  }
+}
+
+MODULE CacheShard*
+cache_sharded_pick(CacheSharded* cs, Str8 key) {
+  U64 hash = rapidhashNano_withSeed(key.cstr, key.size, 0x5eb1);
+  return cs->shards + (hash % cs->shard_count);
+}
+
+MODULE Bool
+cache_sharded_get(CacheSharded* cs, Str8 key, HashMapKV* out) {
+  CacheShard* shard = cache_sharded_pick(cs, key);
+  platform_mutex_lock(&shard->lock);
+  HashMapKV* kv = cache_get(shard->cache, key);
+  if(kv && out) {
+    *out = *kv;
+  }
+  platform_mutex_unlock(&shard->lock);
+  return kv != 0;
+}
+
+MODULE Bool
+cache_sharded_put(CacheSharded* cs, Str8 key, HashMapKV value, U64 bytes) {
+  CacheShard* shard = cache_sharded_pick(cs, key);
+  platform_mutex_lock(&shard->lock);
+  HashMapKV* kv = cache_put(shard->cache, key, bytes);
+  if(kv) {
+    value.k_str = kv->k_str;
+    *kv = value;
+  }
+  platform_mutex_unlock(&shard->lock);
+  return kv != 0;
+}
+
+MODULE Bool
+cache_sharded_remove(CacheSharded* cs, Str8 key, HashMapKV* out) {
+  CacheShard* shard = cache_sharded_pick(cs, key);
+  platform_mutex_lock(&shard->lock);
+  Bool result = cache_remove(shard->cache, key, out);
+  platform_mutex_unlock(&shard->lock);
+  return result;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_CACHE_IMPLEMENTATION */
+#endif /* SEPI_CACHE_H */
@@ -0,0 +1,558 @@
+#ifndef SEPI_CSV_H
+#define SEPI_CSV_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include <stdio.h>
+#include "base.h"
+#include "arena.h"
+#include "string.h"
+#include "platform.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_CSV_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_CSV_IMPLEMENTATION */
+
+#define CSV_BLOCK 64
+/* what a file reader asks fread for; a row longer than the buffer grows it */
+#define CSV_CHUNK MB(1)
+#define CSV_FIELDS_MIN 16
+#define CSV_PARALLEL_MIN_PER_THREAD MB(1)
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+/* NoQuotes treats '"' as an ordinary byte, which is what most TSV wants */
+typedef U32 CsvFlags;
+enum {
+  CsvFlag_NoQuotes = (1 << 0),
+};
+
+typedef U32 CsvError;
+enum {
+  CsvError_None,
+  CsvError_Quote,
+  CsvError_Read,
+};
+
+/* fields point into the input, or into the reader's arena when they had
+   doubled quotes to undo; either way they live until the next row.
+   `offset` is where the row starts in the whole input */
+typedef struct CsvRow CsvRow;
+struct CsvRow {
+  Str8* fields;
+  U64 count;
+  U64 offset;
+};
+
+/* `buffer` [0, size) is the window of input in memory and `base` its
+   offset in the whole input. rows are found 64 bytes at a time: `seps`
+   holds the delimiters and newlines outside quotes of the block before
+   `next` that no field has used yet, `quote_carry` is all ones when that
+   block ended inside quotes. everything past `row_position` in `a` is
+   thrown away by every csv_next */
+typedef struct CsvReader CsvReader;
+struct CsvReader {
+  Arena* a;
+  U64 row_position;
+  FILE* file;
+  U8* buffer;
+  U64 size;
+  U64 capacity;
+  U64 base;
+  Bool eof;
+  U64 at;
+  U64 next;
+  U64 seps;
+  U64 quote_carry;
+  U8 delimiter;
+  CsvFlags flags;
+  Str8* fields;
+  U64 field_capacity;
+  CsvError error;
+  U64 error_offset;
+};
+
+typedef Nothing (*CsvRowFn)(RawPtr user, U32 thread, CsvRow* row);
+
+typedef struct CsvTask CsvTask;
+struct CsvTask {
+  Str8 data;
+  U64 first;
+  U64 last;
+  U64 quotes;
+  U64 carry_first;
+  U64 carry_last;
+  U8 delimiter;
+  CsvFlags flags;
+  CsvRowFn fn;
+  RawPtr user;
+  U32 thread;
+  CsvError error;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE CsvReader csv_reader_memory(Arena* a, Str8 data, U8 delimiter,
+                                   CsvFlags flags);
+MODULE CsvReader csv_reader_file(Arena* a, FILE* file, U8 delimiter,
+                                 CsvFlags flags);
+MODULE Bool csv_next(CsvReader* r, CsvRow* row);
+MODULE CsvError csv_parallel(Str8 data, U8 delimiter, CsvFlags flags,
+                             U32 threads, CsvRowFn fn, RawPtr user);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_CSV_IMPLEMENTATION
+
+/* `seps` gets the delimiters and the newlines of the block */
+#if defined(__AVX2__)
+
+internal Nothing
+csv_classify(const U8* p, U8 delimiter, U64* quotes, U64* seps) {
+  __m256i d = _mm256_set1_epi8((I8)delimiter);
+  __m256i q = _mm256_set1_epi8('"');
+  __m256i n = _mm256_set1_epi8('\n');
+  *quotes = 0;
+  *seps = 0;
+  for(U64 i = 0; i < CSV_BLOCK; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+    __m256i sep = _mm256_or_si256(_mm256_cmpeq_epi8(v, d), _mm256_cmpeq_epi8(v, n));
+    *quotes |= (U64)(U32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, q)) << i;
+    *seps |= (U64)(U32)_mm256_movemask_epi8(sep) << i;
+  }
+}
+
+#elif defined(__SSE2__)
+
+internal Nothing
+csv_classify(const U8* p, U8 delimiter, U64* quotes, U64* seps) {
+  __m128i d = _mm_set1_epi8((I8)delimiter);
+  __m128i q = _mm_set1_epi8('"');
+  __m128i n = _mm_set1_epi8('\n');
+  *quotes = 0;
+  *seps = 0;
+  for(U64 i = 0; i < CSV_BLOCK; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+    __m128i sep = _mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, n));
+    *quotes |= (U64)(U32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << i;
+    *seps |= (U64)(U32)_mm_movemask_epi8(sep) << i;
+  }
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+internal U64
+csv_pack_neon(uint8x16_t* m) {
+  static const U8 weights[16] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+  };
+  uint8x16_t bit = vld1q_u8(weights);
+  uint8x16_t sum = vpaddq_u8(vpaddq_u8(vandq_u8(m[0], bit), vandq_u8(m[1], bit)),
+                             vpaddq_u8(vandq_u8(m[2], bit), vandq_u8(m[3], bit)));
+  sum = vpaddq_u8(sum, sum);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+
+internal Nothing
+csv_classify(const U8* p, U8 delimiter, U64* quotes, U64* seps) {
+  uint8x16_t q[4], sep[4];
+  for(U64 i = 0; i < 4; ++i) {
+    uint8x16_t v = vld1q_u8(p + 16 * i);
+    q[i] = vceqq_u8(v, vdupq_n_u8('"'));
+    sep[i] = vorrq_u8(vceqq_u8(v, vdupq_n_u8(delimiter)), vceqq_u8(v, vdupq_n_u8('\n')));
+  }
+  *quotes = csv_pack_neon(q);
+  *seps = csv_pack_neon(sep);
+}
+
+#else
+
+internal Nothing
+csv_classify(const U8* p, U8 delimiter, U64* quotes, U64* seps) {
+  *quotes = 0;
+  *seps = 0;
+  for(U64 i = 0; i < CSV_BLOCK; ++i) {
+    *quotes |= (U64)(p[i] == '"') << i;
+    *seps |= (U64)(p[i] == delimiter || p[i] == '\n') << i;
+  }
+}
+
+#endif /* __AVX2__ */
+
+/* bit i of the result is the xor of bits 0..i, so inside a quoted run
+   every bit from the opening quote up to the closing one is set */
+internal U64
+csv_prefix_xor(U64 x) {
+#if defined(__AVX2__) && defined(__PCLMUL__)
+  __m128i all = _mm_set1_epi8((I8)0xFF);
+  return (U64)_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, (I64)x), all, 0));
+#else
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+#endif /* __AVX2__ && __PCLMUL__ */
+}
+
+/* the block at `at` of `data`, zero padded past the end. returns the
+   separators outside quotes and moves `carry` on to the next block */
+internal U64
+csv_block(const U8* data, U64 size, U64 at, U8 delimiter, CsvFlags flags,
+          U64* carry) {
+  U8 tail[CSV_BLOCK];
+  const U8* p = data + at;
+  if(at + CSV_BLOCK > size) {
+    MemZeroArray(tail);
+    MemoryCopy(tail, p, size - at);
+    p = tail;
+  }
+  U64 quotes, seps;
+  csv_classify(p, delimiter, &quotes, &seps);
+  if(flags & CsvFlag_NoQuotes) {
+    return seps;
+  }
+  U64 inside = csv_prefix_xor(quotes) ^ *carry;
+  *carry = (U64)((I64)inside >> 63);
+  return seps & ~inside;
+}
+
+internal CsvReader
+csv_reader(Arena* a, U8 delimiter, CsvFlags flags) {
+  AssertAlways(delimiter != 0 && delimiter != '\n' && delimiter != '"');
+  CsvReader r = {0};
+  r.a = a;
+  r.delimiter = delimiter;
+  r.flags = flags;
+  r.field_capacity = CSV_FIELDS_MIN;
+  return r;
+}
+
+MODULE CsvReader
+csv_reader_memory(Arena* a, Str8 data, U8 delimiter, CsvFlags flags) {
+  CsvReader r = csv_reader(a, delimiter, flags);
+  r.buffer = (U8*)data.cstr;
+  r.size = data.size;
+  r.eof = TRUE;
+  r.row_position = arena_get_position(a);
+  return r;
+}
+
+MODULE CsvReader
+csv_reader_file(Arena* a, FILE* file, U8 delimiter, CsvFlags flags) {
+  CsvReader r = csv_reader(a, delimiter, flags);
+  r.file = file;
+  r.capacity = CSV_CHUNK;
+  r.buffer = arena_push_array_no_zero(a, U8, r.capacity);
+  r.row_position = arena_get_position(a);
+  return r;
+}
+
+internal Nothing
+csv_fields_reset(CsvReader* r) {
+  arena_pop_to(r->a, r->row_position);
+  r->fields = arena_push_array_no_zero(r->a, Str8, r->field_capacity);
+}
+
+/* the row in progress moves to the front of the buffer, which doubles
+   when that row already fills it, and the rest is read in behind it.
+   scanning starts over at the row, which is never inside quotes */
+internal Nothing
+csv_refill(CsvReader* r) {
+  U64 keep = r->size - r->at;
+  if(r->at == 0 && r->size == r->capacity) {
+    arena_pop_to(r->a, r->row_position);
+    U8* buffer = arena_push_array_no_zero(r->a, U8, r->capacity * 2);
+    MemoryCopy(buffer, r->buffer, keep);
+    r->buffer = buffer;
+    r->capacity *= 2;
+    r->row_position = arena_get_position(r->a);
+    csv_fields_reset(r);
+  } else if(keep) {
+    memmove(r->buffer, r->buffer + r->at, keep);
+  }
+  r->base += r->at;
+  r->size = keep;
+  r->at = 0;
+  r->next = 0;
+  r->seps = 0;
+  r->quote_carry = 0;
+
+  while(r->size < r->capacity && !r->eof) {
+    U64 read = fread(r->buffer + r->size, 1, r->capacity - r->size, r->file);
+    r->size += read;
+    if(read == 0) {
+      r->eof = TRUE;
+      if(ferror(r->file)) {
+        r->error = CsvError_Read;
+        r->error_offset = r->base + r->size;
+      }
+    }
+  }
+}
+
+internal Nothing
+csv_field_push(CsvReader* r, U64* count, U64 first, U64 last) {
+  if(*count == r->field_capacity) {
+    Str8* fields = arena_push_array_no_zero(r->a, Str8, r->field_capacity * 2);
+    MemoryCopy(fields, r->fields, *count * sizeof(Str8));
+    r->fields = fields;
+    r->field_capacity *= 2;
+  }
+  r->fields[(*count)++] = str8_raw(r->buffer + first, last - first);
+}
+
+/* "a ""b""" is a "b": the outer quotes go and doubled ones are halved.
+   a quote that was never closed keeps what follows it */
+internal Str8
+csv_unquote(CsvReader* r, Str8 field) {
+  Str8 inner = str8_raw((U8*)field.cstr + 1, field.size - 1);
+  if(inner.size && inner.cstr[inner.size - 1] == '"') {
+    inner.size -= 1;
+  }
+  const U8* q = memchr(inner.cstr, '"', inner.size);
+  if(!q) {
+    return inner;
+  }
+  U8* out = arena_push_array_no_zero(r->a, U8, inner.size);
+  const U8* p = (const U8*)inner.cstr;
+  const U8* end = p + inner.size;
+  U64 size = 0;
+  while(q) {
+    U64 run = (U64)(q - p) + 1;
+    MemoryCopy(out + size, p, run);
+    size += run;
+    p = q + 1 + (q + 1 < end && q[1] == '"');
+    q = memchr(p, '"', (U64)(end - p));
+  }
+  MemoryCopy(out + size, p, (U64)(end - p));
+  size += (U64)(end - p);
+  arena_pop(r->a, inner.size - size);
+  return str8_raw(out, size);
+}
+
+/* blank lines are skipped, a "\r\n" ends a row like "\n" does */
+MODULE Bool
+csv_next(CsvReader* r, CsvRow* row) {
+  csv_fields_reset(r);
+  U64 count = 0;
+  U64 first = r->at;
+  Bool done = FALSE;
+
+  while(!done && !r->error) {
+    if(r->seps == 0) {
+      if(r->next + CSV_BLOCK > r->size && !r->eof) {
+        csv_refill(r);
+        count = 0;
+        first = r->at;
+      } else if(r->next < r->size) {
+        r->seps = csv_block(r->buffer, r->size, r->next, r->delimiter, r->flags,
+                            &r->quote_carry);
+        r->next += CSV_BLOCK;
+      } else if(count == 0 && first >= r->size) {
+        return FALSE;
+      } else if(r->quote_carry) {
+        r->error = CsvError_Quote;
+        r->error_offset = r->base + r->at;
+      } else {
+        csv_field_push(r, &count, first, r->size);
+        first = r->size;
+        done = TRUE;
+      }
+      continue;
+    }
+
+    U64 end = r->next - CSV_BLOCK + (U64)__builtin_ctzll(r->seps);
+    r->seps &= r->seps - 1;
+    csv_field_push(r, &count, first, end);
+    first = end + 1;
+    if(r->buffer[end] == '\n') {
+      Str8 only = r->fields[0];
+      if(count == 1 && (only.size == 0 || (only.size == 1 && only.cstr[0] == '\r'))) {
+        count = 0;
+        r->at = first;
+      } else {
+        done = TRUE;
+      }
+    }
+  }
+  if(!done) {
+    return FALSE;
+  }
+
+  Str8* last = &r->fields[count - 1];
+  if(last->size && last->cstr[last->size - 1] == '\r') {
+    last->size -= 1;
+  }
+  if(!(r->flags & CsvFlag_NoQuotes)) {
+    for(U64 i = 0; i < count; ++i) {
+      if(r->fields[i].size && r->fields[i].cstr[0] == '"') {
+        r->fields[i] = csv_unquote(r, r->fields[i]);
+      }
+    }
+  }
+  row->fields = r->fields;
+  row->count = count;
+  row->offset = r->base + r->at;
+  r->at = first;
+  return TRUE;
+}
+
+internal Nothing
+csv_count_task(RawPtr arg) {
+  CsvTask* t = (CsvTask*)arg;
+  const U8* data = (const U8*)t->data.cstr;
+  U64 quotes = 0;
+  U64 at = t->first;
+  for(; at + CSV_BLOCK <= t->last; at += CSV_BLOCK) {
+    U64 q, seps;
+    csv_classify(data + at, t->delimiter, &q, &seps);
+    quotes += (U64)__builtin_popcountll(q);
+  }
+  for(; at < t->last; ++at) {
+    quotes += data[at] == '"';
+  }
+  t->quotes = quotes;
+}
+
+/* the first row that starts at or after `from`, where `carry` is all
+   ones when an odd number of quotes come before `from` */
+internal U64
+csv_row_start(CsvTask* t, U64 from, U64 carry) {
+  const U8* data = (const U8*)t->data.cstr;
+  U64 size = t->data.size;
+  if(from == 0 || from >= size) {
+    return Min(from, size);
+  }
+  /* the byte before `from` decides whether a row starts right at it */
+  U64 at = from - 1;
+  carry ^= data[at] == '"' && !(t->flags & CsvFlag_NoQuotes) ? ~0ull : 0;
+  for(; at < size; at += CSV_BLOCK) {
+    U64 seps = csv_block(data, size, at, t->delimiter, t->flags, &carry);
+    for(; seps; seps &= seps - 1) {
+      U64 end = at + (U64)__builtin_ctzll(seps);
+      if(data[end] == '\n') {
+        return end + 1;
+      }
+    }
+  }
+  return size;
+}
+
+internal Nothing
+csv_parse_task(RawPtr arg) {
+  CsvTask* t = (CsvTask*)arg;
+  U64 start = csv_row_start(t, t->first, t->carry_first);
+  U64 end = csv_row_start(t, t->last, t->carry_last);
+  if(start >= end) {
+    return;
+  }
+  Arena* a = arena_alloc();
+  CsvReader r = csv_reader_memory(a, str8_raw((U8*)t->data.cstr + start, end - start),
+                                  t->delimiter, t->flags);
+  CsvRow row;
+  r.base = start;
+  while(csv_next(&r, &row)) {
+    t->fn(t->user, t->thread, &row);
+  }
+  t->error = r.error;
+  arena_release(a);
+}
+
+internal Nothing
+csv_parallel_run(Arena* a, CsvTask* tasks, U32 count, PlatformThreadFn fn) {
+  ArenaScratch s = arena_scratch_begin(a);
+  PlatformThread* workers = arena_push_array(a, PlatformThread, count);
+  U32 started = 1;
+  for(; started < count; ++started) {
+    if(!platform_thread_start(&workers[started], fn, &tasks[started])) {
+      break;
+    }
+  }
+  fn(&tasks[0]);
+  for(U32 t = started; t < count; ++t) {
+    fn(&tasks[t]);
+  }
+  for(U32 t = 1; t < started; ++t) {
+    platform_thread_join(&workers[t]);
+  }
+  arena_scratch_end(s);
+}
+
+/* the input is cut into one range per thread. a first pass counts the
+   quotes of every range, so each cut knows whether it falls inside a
+   quoted field; then every thread moves its cuts forward to the next
+   newline outside quotes and reads the rows in between with its own
+   reader and arena. `fn` runs on the threads, rows of one thread come
+   in order */
+MODULE CsvError
+csv_parallel(Str8 data, U8 delimiter, CsvFlags flags, U32 threads, CsvRowFn fn,
+             RawPtr user) {
+  if(threads == 0) {
+    threads = platform_get_cpu_cores();
+  }
+  U32 used = (U32)Max(1, Min(threads, data.size / CSV_PARALLEL_MIN_PER_THREAD));
+  Arena* scratch = arena_alloc();
+  CsvTask* tasks = arena_push_array(scratch, CsvTask, used);
+  for(U32 t = 0; t < used; ++t) {
+    tasks[t] = (CsvTask) {
+      .data = data,
+      .first = (data.size * t) / used,
+      .last = (data.size * (t + 1)) / used,
+      .delimiter = delimiter,
+      .flags = flags,
+      .fn = fn,
+      .user = user,
+      .thread = t,
+    };
+  }
+  if(!(flags & CsvFlag_NoQuotes)) {
+    csv_parallel_run(scratch, tasks, used, csv_count_task);
+  }
+  U64 carry = 0;
+  for(U32 t = 0; t < used; ++t) {
+    tasks[t].carry_first = carry;
+    carry ^= tasks[t].quotes & 1 ? ~0ull : 0;
+    tasks[t].carry_last = carry;
+  }
+  csv_parallel_run(scratch, tasks, used, csv_parse_task);
+
+  CsvError error = CsvError_None;
+  for(U32 t = 0; t < used && !error; ++t) {
+    error = tasks[t].error;
+  }
+  arena_release(scratch);
+  return error;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_CSV_IMPLEMENTATION */
+#endif /* SEPI_CSV_H */
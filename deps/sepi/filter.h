@@ -0,0 +1,376 @@
+#ifndef SEPI_FILTER_H
+#define SEPI_FILTER_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "arena.h"
+#include "string.h"
+#include "hashmap.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif /* __AVX2__ */
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_FILTER_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_FILTER_IMPLEMENTATION */
+
+#define BLOOM_BLOCK_WORDS 8
+#define BLOOM_DEFAULT_BITS_PER_KEY 10
+#define CUCKOO_BUCKET_SLOTS 4
+#define CUCKOO_MAX_KICKS 500
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+/* split block bloom filter: every key sets one bit in each of the eight
+   32-bit words of a single 256-bit block, so a probe touches one line */
+typedef struct BloomBlock BloomBlock;
+struct BloomBlock {
+  U32 words[BLOOM_BLOCK_WORDS];
+};
+
+typedef struct BloomFilter BloomFilter;
+struct BloomFilter {
+  BloomBlock* blocks;
+  U64 block_count;
+};
+
+/* four 16-bit fingerprints per 8-byte bucket, zero marks an empty slot */
+typedef struct CuckooFilter CuckooFilter;
+struct CuckooFilter {
+  U64* buckets;
+  U64 bucket_mask;
+  U64 count;
+  U64 rng;
+  U16 victim_fingerprint;
+  U64 victim_bucket;
+  Bool has_victim;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE BloomFilter* bloom_init(Arena* a, U64 expected, U64 bits_per_key);
+MODULE Nothing bloom_clear(BloomFilter* bf);
+MODULE Nothing bloom_add_hash(BloomFilter* bf, U64 hash);
+MODULE Bool bloom_test_hash(BloomFilter* bf, U64 hash);
+MODULE Nothing bloom_add(BloomFilter* bf, Str8 key);
+MODULE Bool bloom_test(BloomFilter* bf, Str8 key);
+MODULE Nothing bloom_add_hashmap(BloomFilter* bf, HashMap* hm);
+MODULE HashMapKV* bloom_find(BloomFilter* bf, HashMap* hm, Str8 key);
+
+MODULE CuckooFilter* cuckoo_init(Arena* a, U64 expected);
+MODULE Bool cuckoo_add_hash(CuckooFilter* cf, U64 hash);
+MODULE Bool cuckoo_test_hash(CuckooFilter* cf, U64 hash);
+MODULE Bool cuckoo_remove_hash(CuckooFilter* cf, U64 hash);
+MODULE Bool cuckoo_add(CuckooFilter* cf, Str8 key);
+MODULE Bool cuckoo_test(CuckooFilter* cf, Str8 key);
+MODULE Bool cuckoo_remove(CuckooFilter* cf, Str8 key);
+MODULE Bool cuckoo_add_hashmap(CuckooFilter* cf, HashMap* hm);
+MODULE HashMapKV* cuckoo_find(CuckooFilter* cf, HashMap* hm, Str8 key);
+MODULE HashMapKV cuckoo_pop(CuckooFilter* cf, HashMap* hm, Str8 key);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_FILTER_IMPLEMENTATION
+
+internal const U32 bloom_salts[BLOOM_BLOCK_WORDS] = {
+  0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+MODULE BloomFilter*
+bloom_init(Arena* a, U64 expected, U64 bits_per_key) {
+  BloomFilter* bf = arena_push_array(a, BloomFilter, 1);
+  U64 bits = Max(expected, 1) *
+             (bits_per_key ? bits_per_key : BLOOM_DEFAULT_BITS_PER_KEY);
+  bf->block_count = Max(1, (bits + 255) / 256);
+  bf->blocks = arena_push_array_aligned(a, BloomBlock, bf->block_count, 64);
+  return bf;
+}
+
+MODULE Nothing
+bloom_clear(BloomFilter* bf) {
+  MemZeroTyped(bf->blocks, bf->block_count);
+}
+
+MODULE BloomBlock*
+bloom_block(BloomFilter* bf, U64 hash) {
+  U64 i = ((hash >> 32) * bf->block_count) >> 32;
+  return bf->blocks + i;
+}
+
+#if defined(__AVX2__)
+
+MODULE __m256i
+bloom_mask(U32 key) {
+  __m256i salts = _mm256_loadu_si256((const __m256i*)bloom_salts);
+  __m256i products = _mm256_mullo_epi32(_mm256_set1_epi32((I32)key), salts);
+  __m256i shifts = _mm256_srli_epi32(products, 27);
+  return _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+}
+
+MODULE Nothing
+bloom_add_hash(BloomFilter* bf, U64 hash) {
+  __m256i* block = (__m256i*)bloom_block(bf, hash);
+  _mm256_store_si256(block, _mm256_or_si256(_mm256_load_si256(block),
+                                            bloom_mask((U32)hash)));
+}
+
+MODULE Bool
+bloom_test_hash(BloomFilter* bf, U64 hash) {
+  __m256i* block = (__m256i*)bloom_block(bf, hash);
+  return _mm256_testc_si256(_mm256_load_si256(block), bloom_mask((U32)hash));
+}
+
+#else /* scalar, written so the eight lanes can be auto-vectorized */
+
+MODULE Nothing
+bloom_add_hash(BloomFilter* bf, U64 hash) {
+  BloomBlock* block = bloom_block(bf, hash);
+  U32 key = (U32)hash;
+  for(U32 i = 0; i < BLOOM_BLOCK_WORDS; ++i) {
+    block->words[i] |= 1u << ((key * bloom_salts[i]) >> 27);
+  }
+}
+
+MODULE Bool
+bloom_test_hash(BloomFilter* bf, U64 hash) {
+  BloomBlock* block = bloom_block(bf, hash);
+  U32 key = (U32)hash;
+  U32 missing = 0;
+  for(U32 i = 0; i < BLOOM_BLOCK_WORDS; ++i) {
+    U32 mask = 1u << ((key * bloom_salts[i]) >> 27);
+    missing |= (block->words[i] & mask) ^ mask;
+  }
+  return missing == 0;
+}
+
+#endif /* __AVX2__ */
+
+/* keyed variants use hashmap_hasher, maps with their own strategy or seed go
+   through the *_hashmap and *_find helpers or the *_hash variants */
+MODULE Nothing
+bloom_add(BloomFilter* bf, Str8 key) {
+  bloom_add_hash(bf, hashmap_hasher(key));
+}
+
+MODULE Bool
+bloom_test(BloomFilter* bf, Str8 key) {
+  return bloom_test_hash(bf, hashmap_hasher(key));
+}
+
+MODULE Nothing
+bloom_add_hashmap(BloomFilter* bf, HashMap* hm) {
+  for(U64 i = 0; i < hm->capacity; ++i) {
+    for(HashMapNode* itr = hm->list[i].first; itr != 0; itr = itr->next) {
+      bloom_add_hash(bf, hashmap_hash(hm, itr->kv.k_str));
+    }
+  }
+}
+
+MODULE HashMapKV*
+bloom_find(BloomFilter* bf, HashMap* hm, Str8 key) {
+  U64 hash = hashmap_hash(hm, key);
+  if(!bloom_test_hash(bf, hash)) {
+    return 0;
+  }
+  return hashmap_find_with_hash(hm, hash, key);
+}
+
+MODULE CuckooFilter*
+cuckoo_init(Arena* a, U64 expected) {
+  CuckooFilter* cf = arena_push_array(a, CuckooFilter, 1);
+  U64 wanted = Max(1, (expected * 100 / 95 + CUCKOO_BUCKET_SLOTS - 1) /
+                   CUCKOO_BUCKET_SLOTS);
+  U64 count = 1;
+  while(count < wanted) {
+    count <<= 1;
+  }
+  cf->bucket_mask = count - 1;
+  cf->buckets = arena_push_array_aligned(a, U64, count, 64);
+  cf->rng = 0x2545f4914f6cdd1dull;
+  return cf;
+}
+
+MODULE U16
+cuckoo_fingerprint(U64 hash) {
+  U16 fp = (U16)(hash >> 48);
+  return fp ? fp : 1;
+}
+
+MODULE U64
+cuckoo_alt_bucket(CuckooFilter* cf, U64 bucket, U16 fp) {
+  return (bucket ^ ((U64)fp * 0xc6a4a7935bd1e995ull)) & cf->bucket_mask;
+}
+
+/* SWAR: one lane per fingerprint, high bit set where the lane equals fp */
+MODULE U64
+cuckoo_match(U64 bucket, U16 fp) {
+  U64 x = bucket ^ (0x0001000100010001ull * fp);
+  return (x - 0x0001000100010001ull) & ~x & 0x8000800080008000ull;
+}
+
+MODULE Bool
+cuckoo_bucket_insert(CuckooFilter* cf, U64 bucket, U16 fp) {
+  U64 empty = cuckoo_match(cf->buckets[bucket], 0);
+  if(empty == 0) {
+    return FALSE;
+  }
+  U32 lane = (U32)__builtin_ctzll(empty) >> 4;
+  cf->buckets[bucket] |= (U64)fp << (lane * 16);
+  return TRUE;
+}
+
+MODULE Bool
+cuckoo_bucket_remove(CuckooFilter* cf, U64 bucket, U16 fp) {
+  U64 hit = cuckoo_match(cf->buckets[bucket], fp);
+  if(hit == 0) {
+    return FALSE;
+  }
+  U32 lane = (U32)__builtin_ctzll(hit) >> 4;
+  cf->buckets[bucket] &= ~((U64)0xffff << (lane * 16));
+  return TRUE;
+}
+
+MODULE Bool
+cuckoo_add_hash(CuckooFilter* cf, U64 hash) {
+  if(cf->has_victim) {
+    return FALSE;
+  }
+
+  U16 fp = cuckoo_fingerprint(hash);
+  U64 i1 = hash & cf->bucket_mask;
+  U64 i2 = cuckoo_alt_bucket(cf, i1, fp);
+  if(cuckoo_bucket_insert(cf, i1, fp) || cuckoo_bucket_insert(cf, i2, fp)) {
+    cf->count += 1;
+    return TRUE;
+  }
+
+  U64 bucket = (cf->rng & 1) ? i1 : i2;
+  for(U32 kick = 0; kick < CUCKOO_MAX_KICKS; ++kick) {
+    cf->rng ^= cf->rng << 13;
+    cf->rng ^= cf->rng >> 7;
+    cf->rng ^= cf->rng << 17;
+    U32 lane = (U32)(cf->rng & (CUCKOO_BUCKET_SLOTS - 1));
+    U16 evicted = (U16)(cf->buckets[bucket] >> (lane * 16));
+    cf->buckets[bucket] &= ~((U64)0xffff << (lane * 16));
+    cf->buckets[bucket] |= (U64)fp << (lane * 16);
+    fp = evicted;
+    bucket = cuckoo_alt_bucket(cf, bucket, fp);
+    if(cuckoo_bucket_insert(cf, bucket, fp)) {
+      cf->count += 1;
+      return TRUE;
+    }
+  }
+
+  /* keep the last homeless fingerprint so nothing already added is lost */
+  cf->victim_fingerprint = fp;
+  cf->victim_bucket = bucket;
+  cf->has_victim = TRUE;
+  cf->count += 1;
+  return TRUE;
+}
+
+MODULE Bool
+cuckoo_test_hash(CuckooFilter* cf, U64 hash) {
+  U16 fp = cuckoo_fingerprint(hash);
+  U64 i1 = hash & cf->bucket_mask;
+  U64 i2 = cuckoo_alt_bucket(cf, i1, fp);
+  if(cuckoo_match(cf->buckets[i1], fp) | cuckoo_match(cf->buckets[i2], fp)) {
+    return TRUE;
+  }
+  return cf->has_victim && cf->victim_fingerprint == fp &&
+         (cf->victim_bucket == i1 || cf->victim_bucket == i2);
+}
+
+MODULE Bool
+cuckoo_remove_hash(CuckooFilter* cf, U64 hash) {
+  U16 fp = cuckoo_fingerprint(hash);
+  U64 i1 = hash & cf->bucket_mask;
+  U64 i2 = cuckoo_alt_bucket(cf, i1, fp);
+  if(cf->has_victim && cf->victim_fingerprint == fp &&
+     (cf->victim_bucket == i1 || cf->victim_bucket == i2)) {
+    cf->has_victim = FALSE;
+    cf->count -= 1;
+    return TRUE;
+  }
+  if(cuckoo_bucket_remove(cf, i1, fp) || cuckoo_bucket_remove(cf, i2, fp)) {
+    cf->count -= 1;
+    if(cf->has_victim) {
+      cf->has_victim = FALSE;
+      cf->count -= 1;
+      cuckoo_add_hash(cf, ((U64)cf->victim_fingerprint << 48) |
+                      cf->victim_bucket);
+    }
+    return TRUE;
+  }
+  return FALSE;
+}
+
+MODULE Bool
+cuckoo_add(CuckooFilter* cf, Str8 key) {
+  return cuckoo_add_hash(cf, hashmap_hasher(key));
+}
+
+MODULE Bool
+cuckoo_test(CuckooFilter* cf, Str8 key) {
+  return cuckoo_test_hash(cf, hashmap_hasher(key));
+}
+
+MODULE Bool
+cuckoo_remove(CuckooFilter* cf, Str8 key) {
+  return cuckoo_remove_hash(cf, hashmap_hasher(key));
+}
+
+MODULE Bool
+cuckoo_add_hashmap(CuckooFilter* cf, HashMap* hm) {
+  Bool result = TRUE;
+  for(U64 i = 0; i < hm->capacity; ++i) {
+    for(HashMapNode* itr = hm->list[i].first; itr != 0; itr = itr->next) {
+      result &= cuckoo_add_hash(cf, hashmap_hash(hm, itr->kv.k_str));
+    }
+  }
+  return result;
+}
+
+MODULE HashMapKV*
+cuckoo_find(CuckooFilter* cf, HashMap* hm, Str8 key) {
+  U64 hash = hashmap_hash(hm, key);
+  if(!cuckoo_test_hash(cf, hash)) {
+    return 0;
+  }
+  return hashmap_find_with_hash(hm, hash, key);
+}
+
+MODULE HashMapKV
+cuckoo_pop(CuckooFilter* cf, HashMap* hm, Str8 key) {
+  HashMapKV kv = {0};
+  U64 hash = hashmap_hash(hm, key);
+  if(cuckoo_test_hash(cf, hash) && hashmap_find_with_hash(hm, hash, key)) {
+    cuckoo_remove_hash(cf, hash);
+    kv = hashmap_pop(hm, key);
+  }
+  return kv;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_FILTER_IMPLEMENTATION */
+#endif /* SEPI_FILTER_H */
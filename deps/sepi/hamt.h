@@ -0,0 +1,430 @@
+#ifndef SEPI_HAMT_H
+#define SEPI_HAMT_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "arena.h"
+#include "string.h"
+#include "hashmap.h"
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_HAMT_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_HAMT_IMPLEMENTATION */
+
+#define HAMT_BITS 5
+#define HAMT_MASK ((1u << HAMT_BITS) - 1)
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+typedef struct HamtEntry HamtEntry;
+struct HamtEntry {
+  U64 hash;
+  HashMapKV kv;
+};
+
+/* nodes are never modified once published. a node with `collisions` set
+   holds entries whose 64-bit hashes are identical and has no bitmaps */
+typedef struct HamtNode HamtNode;
+struct HamtNode {
+  U32 datamap;
+  U32 nodemap;
+  U32 collisions;
+  HamtEntry* entries;
+  HamtNode** children;
+};
+
+/* a version of the map, copying it is an O(1) snapshot */
+typedef struct Hamt Hamt;
+struct Hamt {
+  HamtNode* root;
+  U64 count;
+};
+
+/* single writer, any number of readers. the writer publishes versions
+   allocated from its arena, readers take snapshots without locking */
+typedef struct HamtRef HamtRef;
+struct HamtRef {
+  Hamt* current;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE Hamt hamt_empty(void);
+MODULE HashMapKV* hamt_get(Hamt h, Str8 key);
+MODULE Hamt hamt_set(Arena* a, Hamt h, HashMapKV kv);
+MODULE Hamt hamt_set_str8(Arena* a, Hamt h, Str8 key, Str8 value);
+MODULE Hamt hamt_set_rawptr(Arena* a, Hamt h, Str8 key, RawPtr value);
+MODULE Hamt hamt_set_u64(Arena* a, Hamt h, Str8 key, U64 value);
+MODULE Hamt hamt_remove(Arena* a, Hamt h, Str8 key);
+MODULE HashMapKV* hamt_kvs(Arena* a, Hamt h);
+MODULE Nothing hamt_ref_publish(Arena* a, HamtRef* ref, Hamt h);
+MODULE Hamt hamt_ref_snapshot(HamtRef* ref);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_HAMT_IMPLEMENTATION
+
+MODULE U32
+hamt_popcount(U32 x) {
+  return (U32)__builtin_popcount(x);
+}
+
+MODULE U32
+hamt_bit(U64 hash, U32 shift) {
+  return 1u << ((hash >> shift) & HAMT_MASK);
+}
+
+MODULE U32
+hamt_index(U32 map, U32 bit) {
+  return hamt_popcount(map & (bit - 1));
+}
+
+MODULE U32
+hamt_data_count(HamtNode* n) {
+  return n->collisions ? n->collisions : hamt_popcount(n->datamap);
+}
+
+MODULE HamtNode*
+hamt_node_alloc(Arena* a, U32 data_count, U32 child_count) {
+  U64 size = sizeof(HamtNode) + sizeof(HamtEntry) * data_count +
+             sizeof(HamtNode*) * child_count;
+  HamtNode* n = (HamtNode*)arena_push(a, size, AlignOf(HamtNode), FALSE);
+  n->datamap = n->nodemap = n->collisions = 0;
+  n->entries = (HamtEntry*)(n + 1);
+  n->children = (HamtNode**)(n->entries + data_count);
+  return n;
+}
+
+MODULE HamtNode*
+hamt_node_copy(Arena* a, HamtNode* n) {
+  U32 data_count = hamt_data_count(n);
+  U32 child_count = hamt_popcount(n->nodemap);
+  HamtNode* copy = hamt_node_alloc(a, data_count, child_count);
+  copy->datamap = n->datamap;
+  copy->nodemap = n->nodemap;
+  copy->collisions = n->collisions;
+  MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * data_count);
+  MemoryCopy(copy->children, n->children, sizeof(HamtNode*) * child_count);
+  return copy;
+}
+
+MODULE HamtNode*
+hamt_merge(Arena* a, U32 shift, HamtEntry* e0, HamtEntry* e1) {
+  if(shift >= 64) {
+    HamtNode* n = hamt_node_alloc(a, 2, 0);
+    n->collisions = 2;
+    n->entries[0] = *e0;
+    n->entries[1] = *e1;
+    return n;
+  }
+
+  U32 b0 = hamt_bit(e0->hash, shift);
+  U32 b1 = hamt_bit(e1->hash, shift);
+  if(b0 == b1) {
+    HamtNode* n = hamt_node_alloc(a, 0, 1);
+    n->nodemap = b0;
+    n->children[0] = hamt_merge(a, shift + HAMT_BITS, e0, e1);
+    return n;
+  }
+
+  HamtNode* n = hamt_node_alloc(a, 2, 0);
+  n->datamap = b0 | b1;
+  n->entries[b0 < b1 ? 0 : 1] = *e0;
+  n->entries[b0 < b1 ? 1 : 0] = *e1;
+  return n;
+}
+
+MODULE HamtNode*
+hamt_node_set(Arena* a, HamtNode* n, U32 shift, HamtEntry* e, Bool* added) {
+  if(n->collisions) {
+    for(U32 i = 0; i < n->collisions; ++i) {
+      if(str8_cmp(n->entries[i].kv.k_str, e->kv.k_str, 0)) {
+        HamtNode* copy = hamt_node_copy(a, n);
+        copy->entries[i] = *e;
+        return copy;
+      }
+    }
+    HamtNode* copy = hamt_node_alloc(a, n->collisions + 1, 0);
+    copy->collisions = n->collisions + 1;
+    MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * n->collisions);
+    copy->entries[n->collisions] = *e;
+    *added = TRUE;
+    return copy;
+  }
+
+  U32 bit = hamt_bit(e->hash, shift);
+  U32 data_count = hamt_popcount(n->datamap);
+  U32 child_count = hamt_popcount(n->nodemap);
+
+  if(n->datamap & bit) {
+    U32 di = hamt_index(n->datamap, bit);
+    HamtEntry* old = n->entries + di;
+    if(old->hash == e->hash && str8_cmp(old->kv.k_str, e->kv.k_str, 0)) {
+      HamtNode* copy = hamt_node_copy(a, n);
+      copy->entries[di] = *e;
+      return copy;
+    }
+
+    U32 ci = hamt_index(n->nodemap, bit);
+    HamtNode* copy = hamt_node_alloc(a, data_count - 1, child_count + 1);
+    copy->datamap = n->datamap & ~bit;
+    copy->nodemap = n->nodemap | bit;
+    MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * di);
+    MemoryCopy(copy->entries + di, n->entries + di + 1,
+               sizeof(HamtEntry) * (data_count - di - 1));
+    MemoryCopy(copy->children, n->children, sizeof(HamtNode*) * ci);
+    copy->children[ci] = hamt_merge(a, shift + HAMT_BITS, old, e);
+    MemoryCopy(copy->children + ci + 1, n->children + ci,
+               sizeof(HamtNode*) * (child_count - ci));
+    *added = TRUE;
+    return copy;
+  }
+
+  if(n->nodemap & bit) {
+    U32 ci = hamt_index(n->nodemap, bit);
+    HamtNode* copy = hamt_node_copy(a, n);
+    copy->children[ci] = hamt_node_set(a, n->children[ci], shift + HAMT_BITS,
+                                       e, added);
+    return copy;
+  }
+
+  U32 di = hamt_index(n->datamap, bit);
+  HamtNode* copy = hamt_node_alloc(a, data_count + 1, child_count);
+  copy->datamap = n->datamap | bit;
+  copy->nodemap = n->nodemap;
+  MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * di);
+  copy->entries[di] = *e;
+  MemoryCopy(copy->entries + di + 1, n->entries + di,
+             sizeof(HamtEntry) * (data_count - di));
+  MemoryCopy(copy->children, n->children, sizeof(HamtNode*) * child_count);
+  *added = TRUE;
+  return copy;
+}
+
+/* returns `n` itself when the key is absent and 0 when the node empties */
+MODULE HamtNode*
+hamt_node_remove(Arena* a, HamtNode* n, U32 shift, U64 hash, Str8 key) {
+  if(n->collisions) {
+    for(U32 i = 0; i < n->collisions; ++i) {
+      if(str8_cmp(n->entries[i].kv.k_str, key, 0)) {
+        if(n->collisions == 1) {
+          return 0;
+        }
+        HamtNode* copy = hamt_node_alloc(a, n->collisions - 1, 0);
+        copy->collisions = n->collisions - 1;
+        MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * i);
+        MemoryCopy(copy->entries + i, n->entries + i + 1,
+                   sizeof(HamtEntry) * (n->collisions - i - 1));
+        return copy;
+      }
+    }
+    return n;
+  }
+
+  U32 bit = hamt_bit(hash, shift);
+  U32 data_count = hamt_popcount(n->datamap);
+  U32 child_count = hamt_popcount(n->nodemap);
+
+  if(n->datamap & bit) {
+    U32 di = hamt_index(n->datamap, bit);
+    HamtEntry* old = n->entries + di;
+    if(old->hash != hash || !str8_cmp(old->kv.k_str, key, 0)) {
+      return n;
+    }
+    if(data_count == 1 && child_count == 0) {
+      return 0;
+    }
+    HamtNode* copy = hamt_node_alloc(a, data_count - 1, child_count);
+    copy->datamap = n->datamap & ~bit;
+    copy->nodemap = n->nodemap;
+    MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * di);
+    MemoryCopy(copy->entries + di, n->entries + di + 1,
+               sizeof(HamtEntry) * (data_count - di - 1));
+    MemoryCopy(copy->children, n->children, sizeof(HamtNode*) * child_count);
+    return copy;
+  }
+
+  if(n->nodemap & bit) {
+    U32 ci = hamt_index(n->nodemap, bit);
+    HamtNode* child = n->children[ci];
+    HamtNode* updated = hamt_node_remove(a, child, shift + HAMT_BITS, hash, key);
+    if(updated == child) {
+      return n;
+    }
+
+    Bool inline_single = updated && updated->nodemap == 0 &&
+                         hamt_data_count(updated) == 1;
+    if(updated && !inline_single) {
+      HamtNode* copy = hamt_node_copy(a, n);
+      copy->children[ci] = updated;
+      return copy;
+    }
+    if(!updated && data_count == 0 && child_count == 1) {
+      return 0;
+    }
+
+    /* drop the child, pulling its last entry up into this node if any */
+    U32 extra = inline_single ? 1 : 0;
+    HamtNode* copy = hamt_node_alloc(a, data_count + extra, child_count - 1);
+    copy->datamap = n->datamap | (inline_single ? bit : 0);
+    copy->nodemap = n->nodemap & ~bit;
+    U32 di = hamt_index(n->datamap, bit);
+    MemoryCopy(copy->entries, n->entries, sizeof(HamtEntry) * di);
+    if(inline_single) {
+      copy->entries[di] = updated->entries[0];
+    }
+    MemoryCopy(copy->entries + di + extra, n->entries + di,
+               sizeof(HamtEntry) * (data_count - di));
+    MemoryCopy(copy->children, n->children, sizeof(HamtNode*) * ci);
+    MemoryCopy(copy->children + ci, n->children + ci + 1,
+               sizeof(HamtNode*) * (child_count - ci - 1));
+    return copy;
+  }
+
+  return n;
+}
+
+MODULE Hamt
+hamt_empty(void) {
+  Hamt h = {0};
+  return h;
+}
+
+MODULE HashMapKV*
+hamt_get(Hamt h, Str8 key) {
+  U64 hash = hashmap_hasher(key);
+  HamtNode* n = h.root;
+  for(U32 shift = 0; n != 0; shift += HAMT_BITS) {
+    if(n->collisions) {
+      for(U32 i = 0; i < n->collisions; ++i) {
+        if(str8_cmp(n->entries[i].kv.k_str, key, 0)) {
+          return &n->entries[i].kv;
+        }
+      }
+      return 0;
+    }
+
+    U32 bit = hamt_bit(hash, shift);
+    if(n->datamap & bit) {
+      HamtEntry* e = n->entries + hamt_index(n->datamap, bit);
+      if(e->hash == hash && str8_cmp(e->kv.k_str, key, 0)) {
+        return &e->kv;
+      }
+      return 0;
+    }
+    if((n->nodemap & bit) == 0) {
+      return 0;
+    }
+    n = n->children[hamt_index(n->nodemap, bit)];
+  }
+  return 0;
+}
+
+MODULE Hamt
+hamt_set(Arena* a, Hamt h, HashMapKV kv) {
+  HamtEntry e = {hashmap_hasher(kv.k_str), kv};
+  Bool added = FALSE;
+
+  if(h.root == 0) {
+    h.root = hamt_node_alloc(a, 1, 0);
+    h.root->datamap = hamt_bit(e.hash, 0);
+    h.root->entries[0] = e;
+    h.count = 1;
+    return h;
+  }
+
+  h.root = hamt_node_set(a, h.root, 0, &e, &added);
+  h.count += added;
+  return h;
+}
+
+MODULE Hamt
+hamt_set_str8(Arena* a, Hamt h, Str8 key, Str8 value) {
+  return hamt_set(a, h, (HashMapKV) {
+    .k_str = key, .v_str = value
+  });
+}
+
+MODULE Hamt
+hamt_set_rawptr(Arena* a, Hamt h, Str8 key, RawPtr value) {
+  return hamt_set(a, h, (HashMapKV) {
+    .k_str = key, .v_rawptr = value
+  });
+}
+
+MODULE Hamt
+hamt_set_u64(Arena* a, Hamt h, Str8 key, U64 value) {
+  return hamt_set(a, h, (HashMapKV) {
+    .k_str = key, .v_u64 = value
+  });
+}
+
+MODULE Hamt
+hamt_remove(Arena* a, Hamt h, Str8 key) {
+  if(h.root == 0) {
+    return h;
+  }
+  HamtNode* root = hamt_node_remove(a, h.root, 0, hashmap_hasher(key), key);
+  if(root != h.root) {
+    h.root = root;
+    h.count -= 1;
+  }
+  return h;
+}
+
+MODULE U64
+hamt_collect(HamtNode* n, HashMapKV* out, U64 at) {
+  U32 data_count = hamt_data_count(n);
+  for(U32 i = 0; i < data_count; ++i) {
+    out[at++] = n->entries[i].kv;
+  }
+  for(U32 i = 0, child_count = hamt_popcount(n->nodemap); i < child_count; ++i) {
+    at = hamt_collect(n->children[i], out, at);
+  }
+  return at;
+}
+
+MODULE HashMapKV*
+hamt_kvs(Arena* a, Hamt h) {
+  HashMapKV* kvs = arena_push_array_no_zero(a, HashMapKV, h.count);
+  if(h.root) {
+    U64 count = hamt_collect(h.root, kvs, 0);
+    Assert(count == h.count);
+  }
+  return kvs;
+}
+
+MODULE Nothing
+hamt_ref_publish(Arena* a, HamtRef* ref, Hamt h) {
+  Hamt* version = arena_push_array_no_zero(a, Hamt, 1);
+  *version = h;
+  __atomic_store_n(&ref->current, version, __ATOMIC_RELEASE);
+}
+
+MODULE Hamt
+hamt_ref_snapshot(HamtRef* ref) {
+  Hamt* version = __atomic_load_n(&ref->current, __ATOMIC_ACQUIRE);
+  return version ? *version : hamt_empty();
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_HAMT_IMPLEMENTATION */
+#endif /* SEPI_HAMT_H */
@@ -0,0 +1,362 @@
+#ifndef SEPI_HASH_H
+#define SEPI_HASH_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "platform.h"
+#include "string.h"
+#include "../rapidhash/rapidhash.h"
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_HASH_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_HASH_IMPLEMENTATION */
+
+#define HASH_BATCH_LANES 4
+#define HASH_BATCH_SHORT_MAX 16
+#define HASH_STREAM_BLOCK 112
+#define HASH_STREAM_TAIL 16
+#define HASH_TREE_LEAF MB(1)
+#define HASH_TREE_WINDOW 256
+#define HASH_TREE_MIN_PER_THREAD 4
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+/* incremental rapidhash, final gives the same value as rapidhash_withSeed
+   over everything passed to update. the first HASH_STREAM_TAIL bytes of
+   `buffer` keep the end of the last mixed block, since the tail read of
+   rapidhash can reach back into it */
+typedef struct HashRapidState HashRapidState;
+struct HashRapidState {
+  U64 seed;
+  U64 lanes[7];
+  U64 total;
+  U64 buffered;
+  Bool mixed;
+  U8 buffer[HASH_STREAM_TAIL + HASH_STREAM_BLOCK];
+};
+
+/* fingerprint over HASH_TREE_LEAF sized leaves: every leaf is hashed on
+   its own and the root hashes the leaf hashes in order. this is not the
+   rapidhash of the whole input, but the streaming and the threaded
+   versions agree with each other */
+typedef struct HashRapidTree HashRapidTree;
+struct HashRapidTree {
+  HashRapidState leaf;
+  HashRapidState root;
+  U64 leaf_fill;
+  U64 leaves;
+};
+
+typedef struct HashRapidTreeTask HashRapidTreeTask;
+struct HashRapidTreeTask {
+  U8* data;
+  U64 size;
+  U64 seed;
+  U64 first;
+  U64 last;
+  U64* hashes;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE Nothing hash_rapid_batch(Str8* keys, U64* hashes, U64 count, U64 seed);
+MODULE Nothing hash_rapid_init(HashRapidState* st, U64 seed);
+MODULE Nothing hash_rapid_update(HashRapidState* st, RawPtr data, U64 size);
+MODULE U64 hash_rapid_final(HashRapidState* st);
+MODULE Nothing hash_rapid_tree_init(HashRapidTree* t, U64 seed);
+MODULE Nothing hash_rapid_tree_update(HashRapidTree* t, RawPtr data, U64 size);
+MODULE U64 hash_rapid_tree_final(HashRapidTree* t);
+MODULE U64 hash_rapid_tree(RawPtr data, U64 size, U64 seed, U32 threads);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_HASH_IMPLEMENTATION
+
+/* the <= 16 byte branch of rapidhash_internal split in three, so the
+   multiplies of several keys can overlap. `base` is the seed after its
+   initial mix, which only has to be done once per batch */
+internal FORCE_INLINE Nothing
+hash_rapid_short_load(Str8 key, U64 base, U64* a, U64* b) {
+  U8* p = (U8*)key.cstr;
+  U64 len = key.size;
+
+  if (len >= 8) {
+    *a = rapid_read64(p);
+    *b = rapid_read64(p + len - 8);
+  } else if (len >= 4) {
+    *a = rapid_read32(p);
+    *b = rapid_read32(p + len - 4);
+  } else if (len > 0) {
+    *a = ((U64)p[0] << 45) | p[len - 1];
+    *b = p[len >> 1];
+  } else {
+    *a = *b = 0;
+  }
+  *a ^= rapid_secret[1];
+  *b ^= base ^ (len >= 4 ? len : 0);
+}
+
+internal FORCE_INLINE U64
+hash_rapid_short_finish(U64 a, U64 b, U64 len) {
+  return rapid_mix(a ^ rapid_secret[7], b ^ rapid_secret[1] ^ len);
+}
+
+/* same values as rapidhash_withSeed on every key. a group with any key
+   longer than HASH_BATCH_SHORT_MAX is hashed one key at a time */
+MODULE Nothing
+hash_rapid_batch(Str8* keys, U64* hashes, U64 count, U64 seed) {
+  U64 base = seed ^ rapid_mix(seed ^ rapid_secret[2], rapid_secret[1]);
+  U64 i = 0;
+
+  for (; i + HASH_BATCH_LANES <= count; i += HASH_BATCH_LANES) {
+    Str8* k = keys + i;
+    U64 longest = Max(Max(k[0].size, k[1].size), Max(k[2].size, k[3].size));
+    if (longest > HASH_BATCH_SHORT_MAX) {
+      for (U32 l = 0; l < HASH_BATCH_LANES; ++l) {
+        hashes[i + l] = rapidhash_withSeed(k[l].cstr, k[l].size, seed);
+      }
+      continue;
+    }
+
+    U64 a0, b0, a1, b1, a2, b2, a3, b3;
+    hash_rapid_short_load(k[0], base, &a0, &b0);
+    hash_rapid_short_load(k[1], base, &a1, &b1);
+    hash_rapid_short_load(k[2], base, &a2, &b2);
+    hash_rapid_short_load(k[3], base, &a3, &b3);
+    rapid_mum(&a0, &b0);
+    rapid_mum(&a1, &b1);
+    rapid_mum(&a2, &b2);
+    rapid_mum(&a3, &b3);
+    hashes[i + 0] = hash_rapid_short_finish(a0, b0, k[0].size);
+    hashes[i + 1] = hash_rapid_short_finish(a1, b1, k[1].size);
+    hashes[i + 2] = hash_rapid_short_finish(a2, b2, k[2].size);
+    hashes[i + 3] = hash_rapid_short_finish(a3, b3, k[3].size);
+  }
+
+  for (; i < count; ++i) {
+    hashes[i] = rapidhash_withSeed(keys[i].cstr, keys[i].size, seed);
+  }
+}
+
+MODULE Nothing
+hash_rapid_init(HashRapidState* st, U64 seed) {
+  MemZeroStruct(st);
+  st->seed = seed;
+  seed ^= rapid_mix(seed ^ rapid_secret[2], rapid_secret[1]);
+  for (U32 l = 0; l < ArrayCount(st->lanes); ++l) {
+    st->lanes[l] = seed;
+  }
+}
+
+/* one round of the > 112 byte loop of rapidhash_internal */
+internal Nothing
+hash_rapid_block(HashRapidState* st, U8* p) {
+  U64* l = st->lanes;
+  l[0] = rapid_mix(rapid_read64(p) ^ rapid_secret[0], rapid_read64(p + 8) ^ l[0]);
+  l[1] = rapid_mix(rapid_read64(p + 16) ^ rapid_secret[1], rapid_read64(p + 24) ^ l[1]);
+  l[2] = rapid_mix(rapid_read64(p + 32) ^ rapid_secret[2], rapid_read64(p + 40) ^ l[2]);
+  l[3] = rapid_mix(rapid_read64(p + 48) ^ rapid_secret[3], rapid_read64(p + 56) ^ l[3]);
+  l[4] = rapid_mix(rapid_read64(p + 64) ^ rapid_secret[4], rapid_read64(p + 72) ^ l[4]);
+  l[5] = rapid_mix(rapid_read64(p + 80) ^ rapid_secret[5], rapid_read64(p + 88) ^ l[5]);
+  l[6] = rapid_mix(rapid_read64(p + 96) ^ rapid_secret[6], rapid_read64(p + 104) ^ l[6]);
+  st->mixed = TRUE;
+}
+
+/* rapidhash only mixes a block once it knows more input follows, so a full
+   buffer waits for the next update before it goes through the lanes */
+MODULE Nothing
+hash_rapid_update(HashRapidState* st, RawPtr data, U64 size) {
+  U8* p = (U8*)data;
+  U8* last = 0;
+  st->total += size;
+
+  if (st->buffered) {
+    U64 take = Min(size, HASH_STREAM_BLOCK - st->buffered);
+    MemoryCopy(st->buffer + HASH_STREAM_TAIL + st->buffered, p, take);
+    st->buffered += take;
+    p += take;
+    size -= take;
+    if (size == 0) {
+      return;
+    }
+    hash_rapid_block(st, st->buffer + HASH_STREAM_TAIL);
+    last = st->buffer + HASH_STREAM_TAIL;
+    st->buffered = 0;
+  }
+
+  for (; size > HASH_STREAM_BLOCK; p += HASH_STREAM_BLOCK,
+       size -= HASH_STREAM_BLOCK) {
+    hash_rapid_block(st, p);
+    last = p;
+  }
+
+  if (last) {
+    MemoryCopy(st->buffer, last + HASH_STREAM_BLOCK - HASH_STREAM_TAIL,
+               HASH_STREAM_TAIL);
+  }
+  MemoryCopy(st->buffer + HASH_STREAM_TAIL, p, size);
+  st->buffered = size;
+}
+
+/* the state is left untouched, more updates can follow */
+MODULE U64
+hash_rapid_final(HashRapidState* st) {
+  U8* p = st->buffer + HASH_STREAM_TAIL;
+  U64 i = st->buffered;
+
+  if (!st->mixed) {
+    return rapidhash_withSeed(p, i, st->seed);
+  }
+
+  U64 seed = 0;
+  for (U32 l = 0; l < ArrayCount(st->lanes); ++l) {
+    seed ^= st->lanes[l];
+  }
+  if (i > 16) {
+    seed = rapid_mix(rapid_read64(p) ^ rapid_secret[2], rapid_read64(p + 8) ^ seed);
+    if (i > 32) {
+      seed = rapid_mix(rapid_read64(p + 16) ^ rapid_secret[2], rapid_read64(p + 24) ^ seed);
+      if (i > 48) {
+        seed = rapid_mix(rapid_read64(p + 32) ^ rapid_secret[1], rapid_read64(p + 40) ^ seed);
+        if (i > 64) {
+          seed = rapid_mix(rapid_read64(p + 48) ^ rapid_secret[1], rapid_read64(p + 56) ^ seed);
+          if (i > 80) {
+            seed = rapid_mix(rapid_read64(p + 64) ^ rapid_secret[2], rapid_read64(p + 72) ^ seed);
+            if (i > 96) {
+              seed = rapid_mix(rapid_read64(p + 80) ^ rapid_secret[1], rapid_read64(p + 88) ^ seed);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  U64 a = rapid_read64(p + i - 16) ^ i;
+  U64 b = rapid_read64(p + i - 8);
+  a ^= rapid_secret[1];
+  b ^= seed;
+  rapid_mum(&a, &b);
+  return rapid_mix(a ^ rapid_secret[7], b ^ rapid_secret[1] ^ i);
+}
+
+MODULE Nothing
+hash_rapid_tree_init(HashRapidTree* t, U64 seed) {
+  hash_rapid_init(&t->leaf, seed);
+  hash_rapid_init(&t->root, seed);
+  t->leaf_fill = 0;
+  t->leaves = 0;
+}
+
+internal Nothing
+hash_rapid_tree_push_leaf(HashRapidTree* t, U64 hash) {
+  hash_rapid_update(&t->root, &hash, sizeof(hash));
+  hash_rapid_init(&t->leaf, t->root.seed);
+  t->leaf_fill = 0;
+  t->leaves += 1;
+}
+
+MODULE Nothing
+hash_rapid_tree_update(HashRapidTree* t, RawPtr data, U64 size) {
+  U8* p = (U8*)data;
+  while (size) {
+    U64 take = Min(size, HASH_TREE_LEAF - t->leaf_fill);
+    if (take == HASH_TREE_LEAF) {
+      hash_rapid_tree_push_leaf(t, rapidhash_withSeed(p, take, t->root.seed));
+    } else {
+      hash_rapid_update(&t->leaf, p, take);
+      t->leaf_fill += take;
+      if (t->leaf_fill == HASH_TREE_LEAF) {
+        hash_rapid_tree_push_leaf(t, hash_rapid_final(&t->leaf));
+      }
+    }
+    p += take;
+    size -= take;
+  }
+}
+
+MODULE U64
+hash_rapid_tree_final(HashRapidTree* t) {
+  HashRapidState root = t->root;
+  if (t->leaf_fill || t->leaves == 0) {
+    U64 hash = hash_rapid_final(&t->leaf);
+    hash_rapid_update(&root, &hash, sizeof(hash));
+  }
+  return hash_rapid_final(&root);
+}
+
+internal Nothing
+hash_rapid_tree_task(RawPtr arg) {
+  HashRapidTreeTask* task = (HashRapidTreeTask*)arg;
+  for (U64 i = task->first; i < task->last; ++i) {
+    U64 at = i * HASH_TREE_LEAF;
+    U64 size = Min(HASH_TREE_LEAF, task->size - at);
+    task->hashes[i] = rapidhash_withSeed(task->data + at, size, task->seed);
+  }
+}
+
+/* leaves are hashed HASH_TREE_WINDOW at a time across the threads, then fed
+   to the root on the calling thread */
+MODULE U64
+hash_rapid_tree(RawPtr data, U64 size, U64 seed, U32 threads) {
+  HashRapidState root;
+  U64 hashes[HASH_TREE_WINDOW];
+  U64 leaves = Max(1, (size + HASH_TREE_LEAF - 1) / HASH_TREE_LEAF);
+
+  if (threads == 0) {
+    threads = platform_get_cpu_cores();
+  }
+  hash_rapid_init(&root, seed);
+
+  for (U64 first = 0; first < leaves; first += HASH_TREE_WINDOW) {
+    U64 count = Min(HASH_TREE_WINDOW, leaves - first);
+    U32 used = (U32)Max(1, Min(threads, count / HASH_TREE_MIN_PER_THREAD));
+    PlatformThread workers[used];
+    HashRapidTreeTask tasks[used];
+    U32 started = 1;
+
+    for (U32 t = 0; t < used; ++t) {
+      tasks[t] = (HashRapidTreeTask) {
+        (U8*)data + first * HASH_TREE_LEAF, size - first * HASH_TREE_LEAF,
+        seed, (count * t) / used, (count * (t + 1)) / used, hashes
+      };
+    }
+    for (; started < used; ++started) {
+      if (!platform_thread_start(&workers[started], hash_rapid_tree_task,
+                                 &tasks[started])) {
+        break;
+      }
+    }
+    hash_rapid_tree_task(&tasks[0]);
+    for (U32 t = started; t < used; ++t) {
+      hash_rapid_tree_task(&tasks[t]);
+    }
+    for (U32 t = 1; t < started; ++t) {
+      platform_thread_join(&workers[t]);
+    }
+
+    hash_rapid_update(&root, hashes, count * sizeof(U64));
+  }
+  return hash_rapid_final(&root);
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_HASH_IMPLEMENTATION */
+#endif /* SEPI_HASH_H */
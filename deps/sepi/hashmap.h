@@ -8,6 +8,7 @@
 #include "base.h"
 #include "string.h"
 #include "arena.h"
+#include "hash.h"
 #include "../rapidhash/rapidhash.h"
 
 /* ===================================================== */
@@ -20,10 +21,54 @@
 #define MODULE static
 #endif /* SEPI_HASHMAP_IMPLEMENTATION */
 
+#define HASHMAP_BUILD_PARTITIONS 1024
+#define HASHMAP_BUILD_MIN_PER_THREAD 16384
+#define HASHMAP_STATS_CHAIN_SLOTS 16
+#define HASHMAP_HASH_BATCH 64
+#define HASHMAP_DEFAULT_SEED 1987
+
+/* define before including to change the strategy of every map that does not
+   pick one in hashmap_init */
+#if !defined(HASHMAP_DEFAULT_HASH)
+#define HASHMAP_DEFAULT_HASH HashMapHash_Rapid
+#endif /* HASHMAP_DEFAULT_HASH */
+
+/* the adaptive strategy uses nano up to this key size, micro up to the next
+   and the full rapidhash past it */
+#define HASHMAP_ADAPTIVE_NANO_MAX 128
+#define HASHMAP_ADAPTIVE_MICRO_MAX 512
+
+#if defined(SEPI_HASHMAP_COUNTERS)
+#define HashMapCount(hm, field, n) ((hm)->counters.field += (n))
+#else
+#define HashMapCount(hm, field, n) noop
+#endif /* SEPI_HASHMAP_COUNTERS */
+
 /* ===================================================== */
 /*                         TYPES                         */
 /* ===================================================== */
 
+/* every strategy hashes keys of up to 48 bytes to the same value, they only
+   differ in code size and in how longer keys are consumed */
+typedef U32 HashMapHash;
+enum {
+  HashMapHash_Rapid,
+  HashMapHash_Micro,
+  HashMapHash_Nano,
+  HashMapHash_Adaptive,
+  /* 4 and 8 byte keys get a single multiply-mix, others go adaptive */
+  HashMapHash_Int,
+};
+
+typedef struct HashMapParams HashMapParams;
+struct HashMapParams {
+  U64 capacity;
+  HashMapHash hash;
+  U64 seed;
+  /* draws `seed` from the OS, keeps the given one if that fails */
+  Bool random_seed;
+};
+
 typedef struct HashMapKV HashMapKV;
 struct HashMapKV {
   union {
@@ -52,20 +97,85 @@ struct HashMapList {
   HashMapNode* last;
 };
 
+typedef struct HashMapCounters HashMapCounters;
+struct HashMapCounters {
+  U64 finds;
+  U64 misses;
+  U64 compares;
+  U64 inserts;
+  U64 pops;
+};
+
 typedef struct HashMap HashMap;
 struct HashMap {
   U64 count;
   U64 capacity;
   HashMapList* list;
   HashMapList free_list;
+  HashMapHash hash;
+  U64 seed;
+#if defined(SEPI_HASHMAP_COUNTERS)
+  HashMapCounters counters;
+#endif /* SEPI_HASHMAP_COUNTERS */
+};
+
+typedef struct HashMapStats HashMapStats;
+struct HashMapStats {
+  U64 count;
+  U64 capacity;
+  U64 used_buckets;
+  U64 empty_buckets;
+  U64 max_chain;
+  U64 free_list_length;
+  U64 estimated_bytes;
+  F64 load_factor;
+  F64 empty_bucket_ratio;
+  F64 average_chain;
+  F64 average_hit_probes;
+  /* last slot collects every chain at least that long */
+  U64 chain_histogram[HASHMAP_STATS_CHAIN_SLOTS];
+  HashMapCounters counters;
+};
+
+typedef struct HashMapBuildItem HashMapBuildItem;
+struct HashMapBuildItem {
+  U64 bucket;
+  U64 index;
+};
+
+typedef struct HashMapBuild HashMapBuild;
+struct HashMapBuild {
+  HashMap* hm;
+  HashMapKV* kvs;
+  U64 count;
+  HashMapNode* nodes;
+  HashMapBuildItem* items;
+  HashMapBuildItem* sorted;
+  U64* histogram;
+  U64* cursor;
+  U64 partitions;
+  U32 threads;
+};
+
+typedef struct HashMapBuildTask HashMapBuildTask;
+struct HashMapBuildTask {
+  HashMapBuild* build;
+  U32 index;
 };
 
 /* ===================================================== */
 /*                          API                          */
 /* ===================================================== */
 
-MODULE HashMap* hashmap_init(Arena* a, U64 cap);
+MODULE HashMap* hashmap_init_(Arena* a, HashMapParams* params);
+MODULE U64 hashmap_hasher(Str8 key);
+MODULE U64 hashmap_hash_with(HashMapHash hash, U64 seed, Str8 key);
+MODULE U64 hashmap_hash(HashMap* hm, Str8 key);
+MODULE Nothing hashmap_hash_batch(HashMap* hm, Str8* keys, U64* hashes,
+                                  U64 count);
 MODULE Nothing hashmap_purge(HashMap *hm);
+MODULE HashMap* hashmap_build(Arena* a, U64 cap, HashMapKV* kvs, U64 count,
+                              U32 threads);
 MODULE HashMapNode* hashmap_push(Arena* a, HashMap* hm, U64 hash, HashMapKV kv);
 MODULE HashMapNode* hashmap_push_str8(Arena *a, HashMap* hm, Str8 key,
                                       Str8 value);
@@ -75,9 +185,31 @@ MODULE HashMapNode* hashmap_push_u32(Arena *a, HashMap* hm, Str8 key,
                                      U32 value);
 MODULE HashMapNode* hashmap_push_u64(Arena *a, HashMap* hm, Str8 key,
                                      U64 value);
+MODULE HashMapKV* hashmap_get_or_insert(Arena* a, HashMap* hm, Str8 key,
+                                        Bool* inserted);
+MODULE HashMapKV* hashmap_get_or_insert_with_hash(Arena* a, HashMap* hm,
+                                                  U64 hash, Str8 key,
+                                                  Bool* inserted);
+MODULE U32* hashmap_get_or_insert_u32(Arena* a, HashMap* hm, Str8 key);
+MODULE U64* hashmap_get_or_insert_u64(Arena* a, HashMap* hm, Str8 key);
+MODULE HashMapKV* hashmap_upsert(Arena* a, HashMap* hm, HashMapKV kv);
+MODULE HashMapKV* hashmap_upsert_str8(Arena* a, HashMap* hm, Str8 key,
+                                      Str8 value);
+MODULE HashMapKV* hashmap_upsert_rawptr(Arena* a, HashMap* hm, Str8 key,
+                                        RawPtr value);
+MODULE HashMapKV* hashmap_upsert_u32(Arena* a, HashMap* hm, Str8 key,
+                                     U32 value);
+MODULE HashMapKV* hashmap_upsert_u64(Arena* a, HashMap* hm, Str8 key,
+                                     U64 value);
 MODULE HashMapKV* hashmap_find(HashMap* hm, Str8 key);
+MODULE HashMapKV* hashmap_find_with_hash(HashMap* hm, U64 hash, Str8 key);
 MODULE HashMapKV hashmap_pop(HashMap* hm, Str8 key);
 MODULE Str8* hashmap_keys(Arena* a, HashMap* hm);
+MODULE Nothing hashmap_resize(Arena* a, HashMap* hm, U64 capacity);
+MODULE HashMapStats hashmap_stats(HashMap* hm);
+
+#define HASHMAP_PARAMS(cap, ...) &(HashMapParams){.capacity = (cap), .hash = HASHMAP_DEFAULT_HASH, .seed = HASHMAP_DEFAULT_SEED, __VA_ARGS__}
+#define hashmap_init(arena, cap, ...) hashmap_init_((arena), HASHMAP_PARAMS((cap), __VA_ARGS__))
 
 /* ===================================================== */
 /*                    IMPLEMENTATION                     */
@@ -114,16 +246,63 @@ hashmap_list_pop(HashMapList* hml) {
 }
 
 MODULE U64
-hashmap_hasher(Str8 str) {
-  return rapidhash_withSeed(str.cstr, str.size, 1987);
-  // return rapidhash(str.cstr, str.size);
+hashmap_hash_int(U64 seed, Str8 key) {
+  U64 k = key.size == 8 ? rapid_read64((U8*)key.cstr)
+                        : rapid_read32((U8*)key.cstr);
+  return rapid_mix(k ^ seed ^ rapid_secret[0], key.size ^ rapid_secret[1]);
+}
+
+MODULE U64
+hashmap_hash_with(HashMapHash hash, U64 seed, Str8 key) {
+  if (hash == HashMapHash_Int && (key.size == 4 || key.size == 8)) {
+    return hashmap_hash_int(seed, key);
+  }
+
+  Bool adaptive = hash == HashMapHash_Adaptive || hash == HashMapHash_Int;
+  if (key.size <= 48 || hash == HashMapHash_Nano ||
+      (adaptive && key.size <= HASHMAP_ADAPTIVE_NANO_MAX)) {
+    return rapidhashNano_withSeed(key.cstr, key.size, seed);
+  }
+  if (hash == HashMapHash_Micro ||
+      (adaptive && key.size <= HASHMAP_ADAPTIVE_MICRO_MAX)) {
+    return rapidhashMicro_withSeed(key.cstr, key.size, seed);
+  }
+  return rapidhash_withSeed(key.cstr, key.size, seed);
+}
+
+/* the default strategy and seed, matches hashmap_hash on a map that did not
+   override either */
+MODULE U64
+hashmap_hasher(Str8 key) {
+  return hashmap_hash_with(HASHMAP_DEFAULT_HASH, HASHMAP_DEFAULT_SEED, key);
+}
+
+MODULE U64
+hashmap_hash(HashMap* hm, Str8 key) {
+  return hashmap_hash_with(hm->hash, hm->seed, key);
+}
+
+MODULE Nothing
+hashmap_hash_batch(HashMap* hm, Str8* keys, U64* hashes, U64 count) {
+  if (hm->hash == HashMapHash_Rapid) {
+    hash_rapid_batch(keys, hashes, count, hm->seed);
+    return;
+  }
+  for (U64 i = 0; i < count; ++i) {
+    hashes[i] = hashmap_hash(hm, keys[i]);
+  }
 }
 
 MODULE HashMap*
-hashmap_init(Arena* a, U64 capacity) {
+hashmap_init_(Arena* a, HashMapParams* params) {
   HashMap* hm = arena_push_array(a, HashMap, 1);
-  hm->capacity = capacity;
-  hm->list = arena_push_array(a, HashMapList, capacity);
+  hm->capacity = params->capacity;
+  hm->list = arena_push_array(a, HashMapList, params->capacity);
+  hm->hash = params->hash;
+  hm->seed = params->seed;
+  if (params->random_seed) {
+    platform_get_entropy(&hm->seed, sizeof(hm->seed));
+  }
   return hm;
 }
 
@@ -137,7 +316,7 @@ hashmap_purge(HashMap *hm) {
 }
 
 MODULE HashMapNode*
-hashmap_push(Arena* a, HashMap* hm, U64 hash, HashMapKV kv) {
+hashmap_node_alloc(Arena* a, HashMap* hm) {
   HashMapNode* hmn;
 
   if (hm->free_list.first != 0) {
@@ -146,28 +325,189 @@ hashmap_push(Arena* a, HashMap* hm, U64 hash, HashMapKV kv) {
     hmn = arena_push_array(a, HashMapNode, 1);
   }
 
-  hmn->next = 0;
-  hmn->kv = kv;
+  return hmn;
+}
 
-  U64 i = hash % hm->capacity;
+MODULE Nothing
+hashmap_list_append(HashMapList* list, HashMapNode* hmn) {
+  hmn->next = 0;
 
-  if (hm->list[i].first == 0) {
-    hm->list[i].first = hm->list[i].last = hmn;
-    hmn->next = 0;
+  if (list->first == 0) {
+    list->first = list->last = hmn;
   } else {
-    hm->list[i].last->next = hmn;
-    hm->list[i].last = hmn;
-    hmn->next = 0;
+    list->last->next = hmn;
+    list->last = hmn;
   }
+}
+
+MODULE HashMapNode*
+hashmap_push(Arena* a, HashMap* hm, U64 hash, HashMapKV kv) {
+  HashMapNode* hmn = hashmap_node_alloc(a, hm);
+  hmn->kv = kv;
+
+  U64 i = hash % hm->capacity;
+  hashmap_list_append(&hm->list[i], hmn);
 
   hm->count += 1;
+  HashMapCount(hm, inserts, 1);
 
   return hmn;
 }
 
+MODULE U64
+hashmap_build_partition(HashMapBuild* b, U64 bucket) {
+  return (bucket * b->partitions) / b->hm->capacity;
+}
+
+MODULE Nothing
+hashmap_build_hash_task(RawPtr arg) {
+  HashMapBuildTask* task = (HashMapBuildTask*)arg;
+  HashMapBuild* b = task->build;
+  U64 first = (b->count * task->index) / b->threads;
+  U64 last = (b->count * (task->index + 1)) / b->threads;
+  U64* histogram = b->histogram + (U64)task->index * b->partitions;
+  Str8 keys[HASHMAP_HASH_BATCH];
+  U64 hashes[HASHMAP_HASH_BATCH];
+
+  for (U64 at = first; at < last; at += HASHMAP_HASH_BATCH) {
+    U64 size = Min(HASHMAP_HASH_BATCH, last - at);
+    for (U64 i = 0; i < size; ++i) {
+      keys[i] = b->kvs[at + i].k_str;
+    }
+    hashmap_hash_batch(b->hm, keys, hashes, size);
+
+    for (U64 i = 0; i < size; ++i) {
+      U64 bucket = hashes[i] % b->hm->capacity;
+      b->items[at + i].bucket = bucket;
+      b->items[at + i].index = at + i;
+      histogram[hashmap_build_partition(b, bucket)] += 1;
+    }
+  }
+}
+
+MODULE Nothing
+hashmap_build_scatter_task(RawPtr arg) {
+  HashMapBuildTask* task = (HashMapBuildTask*)arg;
+  HashMapBuild* b = task->build;
+  U64 first = (b->count * task->index) / b->threads;
+  U64 last = (b->count * (task->index + 1)) / b->threads;
+  U64* offsets = b->histogram + (U64)task->index * b->partitions;
+
+  for (U64 i = first; i < last; ++i) {
+    U64 p = hashmap_build_partition(b, b->items[i].bucket);
+    b->sorted[offsets[p]++] = b->items[i];
+  }
+}
+
+MODULE Nothing
+hashmap_build_layout_task(RawPtr arg) {
+  HashMapBuildTask* task = (HashMapBuildTask*)arg;
+  HashMapBuild* b = task->build;
+  HashMap* hm = b->hm;
+  U64* last_offsets = b->histogram + (U64)(b->threads - 1) * b->partitions;
+
+  for (U64 p = task->index; p < b->partitions; p += b->threads) {
+    U64 first_bucket = (p * hm->capacity + b->partitions - 1) / b->partitions;
+    U64 last_bucket = ((p + 1) * hm->capacity + b->partitions - 1) / b->partitions;
+    U64 first = p == 0 ? 0 : last_offsets[p - 1];
+    U64 last = last_offsets[p];
+
+    for (U64 i = first; i < last; ++i) {
+      b->cursor[b->sorted[i].bucket] += 1;
+    }
+
+    for (U64 bucket = first_bucket, at = first; bucket < last_bucket; ++bucket) {
+      U64 size = b->cursor[bucket];
+      b->cursor[bucket] = at;
+      if (size != 0) {
+        hm->list[bucket].first = b->nodes + at;
+        hm->list[bucket].last = b->nodes + at + size - 1;
+      }
+      at += size;
+    }
+
+    for (U64 i = first; i < last; ++i) {
+      HashMapBuildItem* item = b->sorted + i;
+      HashMapNode* hmn = b->nodes + b->cursor[item->bucket]++;
+      hmn->kv = b->kvs[item->index];
+      hmn->next = hmn == hm->list[item->bucket].last ? 0 : hmn + 1;
+    }
+  }
+}
+
+MODULE Nothing
+hashmap_build_run(HashMapBuild* b, PlatformThreadFn fn) {
+  PlatformThread threads[b->threads];
+  HashMapBuildTask tasks[b->threads];
+  U32 started = 1;
+
+  for (U32 t = 0; t < b->threads; ++t) {
+    tasks[t] = (HashMapBuildTask) {
+      b, t
+    };
+  }
+
+  for (; started < b->threads; ++started) {
+    if (!platform_thread_start(&threads[started], fn, &tasks[started])) {
+      break;
+    }
+  }
+
+  fn(&tasks[0]);
+  for (U32 t = started; t < b->threads; ++t) {
+    fn(&tasks[t]);
+  }
+  for (U32 t = 1; t < started; ++t) {
+    platform_thread_join(&threads[t]);
+  }
+}
+
+MODULE HashMap*
+hashmap_build(Arena* a, U64 capacity, HashMapKV* kvs, U64 count, U32 threads) {
+  HashMap* hm = hashmap_init(a, capacity);
+  HashMapNode* nodes = arena_push_array_no_zero(a, HashMapNode, count);
+  hm->count = count;
+  HashMapCount(hm, inserts, count);
+
+  if (threads == 0) {
+    threads = platform_get_cpu_cores();
+  }
+  threads = (U32)Max(1, Min(threads, count / HASHMAP_BUILD_MIN_PER_THREAD));
+
+  ArenaScratch scratch = arena_scratch_begin(a);
+  HashMapBuild b = {0};
+  b.hm = hm;
+  b.kvs = kvs;
+  b.count = count;
+  b.nodes = nodes;
+  b.threads = threads;
+  b.partitions = Min(capacity, HASHMAP_BUILD_PARTITIONS);
+  b.items = arena_push_array_no_zero(a, HashMapBuildItem, count);
+  b.sorted = arena_push_array_no_zero(a, HashMapBuildItem, count);
+  b.histogram = arena_push_array(a, U64, (U64)threads * b.partitions);
+  b.cursor = arena_push_array(a, U64, capacity);
+
+  hashmap_build_run(&b, hashmap_build_hash_task);
+
+  for (U64 p = 0, at = 0; p < b.partitions; ++p) {
+    for (U32 t = 0; t < threads; ++t) {
+      U64* slot = b.histogram + (U64)t * b.partitions + p;
+      U64 size = *slot;
+      *slot = at;
+      at += size;
+    }
+  }
+
+  hashmap_build_run(&b, hashmap_build_scatter_task);
+  hashmap_build_run(&b, hashmap_build_layout_task);
+
+  arena_scratch_end(scratch);
+  return hm;
+}
+
 MODULE HashMapNode*
 hashmap_push_str8(Arena *a, HashMap* hm, Str8 key, Str8 value) {
-  U64 hash = hashmap_hasher(key);
+  U64 hash = hashmap_hash(hm, key);
   return hashmap_push(a, hm, hash, (HashMapKV) {
     .k_str = key, .v_str = value
   });
@@ -175,7 +515,7 @@ hashmap_push_str8(Arena *a, HashMap* hm, Str8 key, Str8 value) {
 
 MODULE HashMapNode*
 hashmap_push_rawptr(Arena *a, HashMap* hm, Str8 key, RawPtr value) {
-  U64 hash = hashmap_hasher(key);
+  U64 hash = hashmap_hash(hm, key);
   return hashmap_push(a, hm, hash, (HashMapKV) {
     .k_str = key, .v_rawptr = value
   });
@@ -183,7 +523,7 @@ hashmap_push_rawptr(Arena *a, HashMap* hm, Str8 key, RawPtr value) {
 
 MODULE HashMapNode*
 hashmap_push_u32(Arena *a, HashMap* hm, Str8 key, U32 value) {
-  U64 hash = hashmap_hasher(key);
+  U64 hash = hashmap_hash(hm, key);
   return hashmap_push(a, hm, hash, (HashMapKV) {
     .k_str = key, .v_u32 = value
   });
@@ -191,7 +531,7 @@ hashmap_push_u32(Arena *a, HashMap* hm, Str8 key, U32 value) {
 
 MODULE HashMapNode*
 hashmap_push_u64(Arena *a, HashMap* hm, Str8 key, U64 value) {
-  U64 hash = hashmap_hasher(key);
+  U64 hash = hashmap_hash(hm, key);
   return hashmap_push(a, hm, hash, (HashMapKV) {
     .k_str = key, .v_u64 = value
   });
@@ -200,7 +540,7 @@ hashmap_push_u64(Arena *a, HashMap* hm, Str8 key, U64 value) {
 MODULE HashMapNode*
 hashmap_push_u32_str8(Arena *a, HashMap* hm, U32 key, Str8 value) {
   Str8 strkey = str8_raw(&key, sizeof(key));
-  U64 hash = hashmap_hasher(strkey);
+  U64 hash = hashmap_hash(hm, strkey);
   return hashmap_push(a, hm, hash, (HashMapKV) {
     .k_u32 = key, .v_str = value
   });
@@ -208,38 +548,131 @@ hashmap_push_u32_str8(Arena *a, HashMap* hm, U32 key, Str8 value) {
 
 MODULE HashMapKV*
 hashmap_find(HashMap* hm, Str8 key) {
-  U64 hash = hashmap_hasher(key);
+  return hashmap_find_with_hash(hm, hashmap_hash(hm, key), key);
+}
+
+MODULE HashMapKV*
+hashmap_find_with_hash(HashMap* hm, U64 hash, Str8 key) {
   U64 i = hash % hm->capacity;
   HashMapList* list = hm->list + i;
+  HashMapCount(hm, finds, 1);
   for (HashMapNode *hmn = list->first; hmn != 0; hmn = hmn->next) {
+    HashMapCount(hm, compares, 1);
     if (str8_cmp(hmn->kv.k_str, key, 0)) {
       return &hmn->kv;
     }
   }
+  HashMapCount(hm, misses, 1);
   return 0;
 }
 
+MODULE HashMapKV*
+hashmap_get_or_insert(Arena* a, HashMap* hm, Str8 key, Bool* inserted) {
+  return hashmap_get_or_insert_with_hash(a, hm, hashmap_hash(hm, key), key,
+                                         inserted);
+}
+
+MODULE HashMapKV*
+hashmap_get_or_insert_with_hash(Arena* a, HashMap* hm, U64 hash, Str8 key,
+                                Bool* inserted) {
+  U64 i = hash % hm->capacity;
+  HashMapList* list = hm->list + i;
+  HashMapCount(hm, finds, 1);
+  for (HashMapNode *hmn = list->first; hmn != 0; hmn = hmn->next) {
+    HashMapCount(hm, compares, 1);
+    if (str8_cmp(hmn->kv.k_str, key, 0)) {
+      if (inserted) {
+        *inserted = FALSE;
+      }
+      return &hmn->kv;
+    }
+  }
+
+  HashMapNode* hmn = hashmap_node_alloc(a, hm);
+  MemZeroStruct(&hmn->kv);
+  hmn->kv.k_str = key;
+  hashmap_list_append(list, hmn);
+  hm->count += 1;
+  HashMapCount(hm, misses, 1);
+  HashMapCount(hm, inserts, 1);
+
+  if (inserted) {
+    *inserted = TRUE;
+  }
+  return &hmn->kv;
+}
+
+MODULE U32*
+hashmap_get_or_insert_u32(Arena* a, HashMap* hm, Str8 key) {
+  return &hashmap_get_or_insert(a, hm, key, 0)->v_u32;
+}
+
+MODULE U64*
+hashmap_get_or_insert_u64(Arena* a, HashMap* hm, Str8 key) {
+  return &hashmap_get_or_insert(a, hm, key, 0)->v_u64;
+}
+
+MODULE HashMapKV*
+hashmap_upsert(Arena* a, HashMap* hm, HashMapKV kv) {
+  HashMapKV* slot = hashmap_get_or_insert(a, hm, kv.k_str, 0);
+  *slot = kv;
+  return slot;
+}
+
+MODULE HashMapKV*
+hashmap_upsert_str8(Arena* a, HashMap* hm, Str8 key, Str8 value) {
+  return hashmap_upsert(a, hm, (HashMapKV) {
+    .k_str = key, .v_str = value
+  });
+}
+
+MODULE HashMapKV*
+hashmap_upsert_rawptr(Arena* a, HashMap* hm, Str8 key, RawPtr value) {
+  return hashmap_upsert(a, hm, (HashMapKV) {
+    .k_str = key, .v_rawptr = value
+  });
+}
+
+MODULE HashMapKV*
+hashmap_upsert_u32(Arena* a, HashMap* hm, Str8 key, U32 value) {
+  return hashmap_upsert(a, hm, (HashMapKV) {
+    .k_str = key, .v_u32 = value
+  });
+}
+
+MODULE HashMapKV*
+hashmap_upsert_u64(Arena* a, HashMap* hm, Str8 key, U64 value) {
+  return hashmap_upsert(a, hm, (HashMapKV) {
+    .k_str = key, .v_u64 = value
+  });
+}
+
 MODULE HashMapKV
 hashmap_pop(HashMap* hm, Str8 key) {
   HashMapKV kv = {0};
-  U64 hash = hashmap_hasher(key);
+  U64 hash = hashmap_hash(hm, key);
   U64 i = hash % hm->capacity;
   HashMapList* list = hm->list + i;
-  HashMapNode *itr = list->first;
-  HashMapNode *prv = itr;
-  Bool single = list->first == list->last ? TRUE : FALSE;
-  for (; itr != 0; prv = itr, itr = itr->next) {
+  HashMapNode *prv = 0;
+  HashMapCount(hm, pops, 1);
+  for (HashMapNode *itr = list->first; itr != 0; prv = itr, itr = itr->next) {
+    HashMapCount(hm, compares, 1);
     if (str8_cmp(itr->kv.k_str, key, 0)) {
-      prv->next = itr->next;
-      kv = itr->kv;
-      MemZeroStruct(itr);
-      if(single) {
-        MemZeroStruct(list);
+      if (prv) {
+        prv->next = itr->next;
+      } else {
+        list->first = itr->next;
+      }
+      if (list->last == itr) {
+        list->last = prv;
       }
+      kv = itr->kv;
+      hashmap_list_append(&hm->free_list, itr);
       hm->count--;
       return kv;
     }
   }
+  HashMapCount(hm, misses, 1);
   return kv;
 }
 
@@ -255,6 +688,68 @@ hashmap_keys(Arena* a, HashMap* hm) {
   return keys;
 }
 
+MODULE Nothing
+hashmap_resize(Arena* a, HashMap* hm, U64 capacity) {
+  HashMapList* list = arena_push_array(a, HashMapList, capacity);
+  for (U64 i = 0; i < hm->capacity; ++i) {
+    for (HashMapNode *itr = hm->list[i].first, *next; itr != 0; itr = next) {
+      next = itr->next;
+      hashmap_list_append(&list[hashmap_hash(hm, itr->kv.k_str) % capacity], itr);
+    }
+  }
+  hm->list = list;
+  hm->capacity = capacity;
+}
+
+MODULE HashMapStats
+hashmap_stats(HashMap* hm) {
+  HashMapStats st = {0};
+  U64 probes = 0;
+
+  st.count = hm->count;
+  st.capacity = hm->capacity;
+
+  for (U64 i = 0; i < hm->capacity; ++i) {
+    U64 chain = 0;
+    for (HashMapNode *itr = hm->list[i].first; itr != 0; itr = itr->next) {
+      chain += 1;
+    }
+    if (chain == 0) {
+      st.empty_buckets += 1;
+    } else {
+      st.used_buckets += 1;
+    }
+    st.max_chain = Max(st.max_chain, chain);
+    st.chain_histogram[Min(chain, HASHMAP_STATS_CHAIN_SLOTS - 1)] += 1;
+    probes += chain * (chain + 1) / 2;
+  }
+
+  for (HashMapNode *itr = hm->free_list.first; itr != 0; itr = itr->next) {
+    st.free_list_length += 1;
+  }
+
+  st.estimated_bytes = sizeof(HashMap) +
+                       hm->capacity * sizeof(HashMapList) +
+                       (hm->count + st.free_list_length) * sizeof(HashMapNode);
+
+  if (hm->capacity) {
+    st.load_factor = (F64)hm->count / (F64)hm->capacity;
+    st.empty_bucket_ratio = (F64)st.empty_buckets / (F64)hm->capacity;
+  }
+  if (st.used_buckets) {
+    st.average_chain = (F64)hm->count / (F64)st.used_buckets;
+  }
+  if (hm->count) {
+    st.average_hit_probes = (F64)probes / (F64)hm->count;
+  }
+
+#if defined(SEPI_HASHMAP_COUNTERS)
+  st.counters = hm->counters;
+#endif /* SEPI_HASHMAP_COUNTERS */
+
+  return st;
+}
+
 /* ===================================================== */
 /*                          END                          */
 /* ===================================================== */
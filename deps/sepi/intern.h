@@ -0,0 +1,198 @@
+#ifndef SEPI_INTERN_H
+#define SEPI_INTERN_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "platform.h"
+#include "arena.h"
+#include "string.h"
+#include "hashmap.h"
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_INTERN_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_INTERN_IMPLEMENTATION */
+
+#define INTERN_NONE 0
+#define INTERN_DEFAULT_CAPACITY 4096
+#define INTERN_CHUNK_SHIFT 16
+#define INTERN_CHUNK_SIZE (1u << INTERN_CHUNK_SHIFT)
+#define INTERN_MAX_CHUNKS (1u << (32 - INTERN_CHUNK_SHIFT))
+#define INTERN_INITIAL_CHUNKS 8
+#define INTERN_BULK_WINDOW 16
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+typedef U32 Symbol;
+
+/* symbol ids start at 1, INTERN_NONE is never handed out. strings are
+   copied NUL-terminated into `blob`, back to back in insertion order.
+   `chunks` doubles on demand, old tables stay readable in the arena */
+typedef struct InternTable InternTable;
+struct InternTable {
+  Arena* arena;
+  Arena* blob;
+  HashMap* index;
+  Str8** chunks;
+  U32 chunk_capacity;
+  U32 count;
+  PlatformMutex lock;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE InternTable* intern_init(Arena* a, U64 capacity);
+MODULE Nothing intern_release(InternTable* it);
+MODULE Symbol intern_str8(InternTable* it, Str8 s);
+MODULE Symbol intern_str8_sync(InternTable* it, Str8 s);
+MODULE Symbol intern_find(InternTable* it, Str8 s);
+MODULE Str8 intern_lookup(InternTable* it, Symbol id);
+MODULE Nothing intern_bulk(InternTable* it, Str8* strs, Symbol* ids,
+                           U64 count);
+MODULE Nothing intern_bulk_sync(InternTable* it, Str8* strs, Symbol* ids,
+                                U64 count);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_INTERN_IMPLEMENTATION
+
+MODULE InternTable*
+intern_init(Arena* a, U64 capacity) {
+  InternTable* it = arena_push_array(a, InternTable, 1);
+  it->arena = a;
+  it->blob = arena_alloc();
+  it->index = hashmap_init(a, capacity ? capacity : INTERN_DEFAULT_CAPACITY);
+  it->chunks = arena_push_array(a, Str8*, INTERN_INITIAL_CHUNKS);
+  it->chunk_capacity = INTERN_INITIAL_CHUNKS;
+  platform_mutex_init(&it->lock);
+  return it;
+}
+
+MODULE Nothing
+intern_release(InternTable* it) {
+  platform_mutex_destroy(&it->lock);
+  arena_release(it->blob);
+}
+
+MODULE Symbol
+intern_insert(InternTable* it, U64 hash, Str8 s) {
+  Bool inserted = FALSE;
+  HashMapKV* kv = hashmap_get_or_insert_with_hash(it->arena, it->index, hash, s,
+                                                  &inserted);
+  if(!inserted) {
+    return kv->v_u32;
+  }
+
+  Symbol id = it->count + 1;
+  AssertAlways(id != INTERN_NONE);
+
+  Str copy = (Str)arena_push(it->blob, s.size + 1, 1, FALSE);
+  MemoryCopy(copy, s.cstr, s.size);
+  copy[s.size] = 0;
+  kv->k_str = str8_raw(copy, s.size);
+  kv->v_u32 = id;
+
+  U32 chunk = id >> INTERN_CHUNK_SHIFT;
+  if(chunk >= it->chunk_capacity) {
+    U32 capacity = Min(it->chunk_capacity * 2, INTERN_MAX_CHUNKS);
+    Str8** chunks = arena_push_array(it->arena, Str8*, capacity);
+    MemoryCopy(chunks, it->chunks, it->chunk_capacity * sizeof(Str8*));
+    __atomic_store_n(&it->chunks, chunks, __ATOMIC_RELEASE);
+    it->chunk_capacity = capacity;
+  }
+  if(it->chunks[chunk] == 0) {
+    it->chunks[chunk] = arena_push_array(it->arena, Str8, INTERN_CHUNK_SIZE);
+  }
+  it->chunks[chunk][id & (INTERN_CHUNK_SIZE - 1)] = kv->k_str;
+  __atomic_store_n(&it->count, id, __ATOMIC_RELEASE);
+
+  if(it->index->count > it->index->capacity * 2) {
+    hashmap_resize(it->arena, it->index, it->index->capacity * 4);
+  }
+  return id;
+}
+
+MODULE Symbol
+intern_str8(InternTable* it, Str8 s) {
+  return intern_insert(it, hashmap_hash(it->index, s), s);
+}
+
+MODULE Symbol
+intern_str8_sync(InternTable* it, Str8 s) {
+  U64 hash = hashmap_hash(it->index, s);
+  platform_mutex_lock(&it->lock);
+  Symbol id = intern_insert(it, hash, s);
+  platform_mutex_unlock(&it->lock);
+  return id;
+}
+
+/* not safe against concurrent inserts, use intern_str8_sync there */
+MODULE Symbol
+intern_find(InternTable* it, Str8 s) {
+  HashMapKV* kv = hashmap_find(it->index, s);
+  return kv ? kv->v_u32 : INTERN_NONE;
+}
+
+/* safe to call from any thread for ids that were already returned */
+MODULE Str8
+intern_lookup(InternTable* it, Symbol id) {
+  if(id == INTERN_NONE || id > __atomic_load_n(&it->count, __ATOMIC_ACQUIRE)) {
+    return str8_zero();
+  }
+  Str8** chunks = __atomic_load_n(&it->chunks, __ATOMIC_ACQUIRE);
+  return chunks[id >> INTERN_CHUNK_SHIFT][id & (INTERN_CHUNK_SIZE - 1)];
+}
+
+MODULE Nothing
+intern_bulk_(InternTable* it, Str8* strs, Symbol* ids, U64 count, Bool sync) {
+  U64 hashes[INTERN_BULK_WINDOW];
+
+  for(U64 first = 0; first < count; first += INTERN_BULK_WINDOW) {
+    U64 size = Min(INTERN_BULK_WINDOW, count - first);
+    hashmap_hash_batch(it->index, strs + first, hashes, size);
+
+    if(sync) {
+      platform_mutex_lock(&it->lock);
+    }
+    for(U64 i = 0; i < size; ++i) {
+      Prefetch(it->index->list + hashes[i] % it->index->capacity);
+    }
+    for(U64 i = 0; i < size; ++i) {
+      ids[first + i] = intern_insert(it, hashes[i], strs[first + i]);
+    }
+    if(sync) {
+      platform_mutex_unlock(&it->lock);
+    }
+  }
+}
+
+MODULE Nothing
+intern_bulk(InternTable* it, Str8* strs, Symbol* ids, U64 count) {
+  intern_bulk_(it, strs, ids, count, FALSE);
+}
+
+MODULE Nothing
+intern_bulk_sync(InternTable* it, Str8* strs, Symbol* ids, U64 count) {
+  intern_bulk_(it, strs, ids, count, TRUE);
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_INTERN_IMPLEMENTATION */
+#endif /* SEPI_INTERN_H */
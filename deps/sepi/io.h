@@ -5,10 +5,48 @@
 /*                     DEPENDENCIES                      */
 /* ===================================================== */
 
+#include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "base.h"
+#include "arena.h"
+#include "string.h"
+#include "platform.h"
+
+#if defined(OS_LINUX) || defined(OS_MAC)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(OS_LINUX)
+#include <linux/falloc.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/syscall.h>
+#elif defined(OS_WINDOWS) /* OS_WINDOWS */
+#include <winerror.h>
+#include <errhandlingapi.h>
+#include <fileapi.h>
+#include <handleapi.h>
+#include <memoryapi.h>
+#include <processthreadsapi.h>
+#include <winbase.h>
+#endif
+
+/* fcntl.h only has O_DIRECT under _GNU_SOURCE, which base.h can't turn
+   on once a libc header came first */
+#if defined(OS_LINUX) && !defined(O_DIRECT)
+#if defined(CPU_ARM64) || defined(CPU_ARM32)
+#define O_DIRECT 0200000
+#else
+#define O_DIRECT 040000
+#endif /* CPU_ARM64 || CPU_ARM32 */
+#endif /* OS_LINUX && !O_DIRECT */
 
 /* ===================================================== */
 /*                       CONSTANTS                       */
@@ -20,11 +58,281 @@
 #define MODULE static
 #endif /* SEPI_IO_IMPLEMENTATION */
 
+/* the most a single read asks for */
+#define IO_READ_CHUNK MB(16)
+/* io_uring submission entries; every file in flight holds at most three */
+#define IO_BATCH_DEPTH 256
+#define IO_BATCH_FILES (IO_BATCH_DEPTH / 4)
+#define IO_BATCH_THREADS 8
+/* what io_stream_open reads at a time when asked for 0 */
+#define IO_STREAM_CHUNK MB(4)
+/* what io_writer_open buffers when asked for 0, and the most pieces one
+   writev takes */
+#define IO_WRITE_BUFFER MB(1)
+#define IO_WRITE_PIECES 64
+/* files a scan worker keeps per chunk, and what one getdents64 fills */
+#define IO_SCAN_CHUNK 256
+#define IO_SCAN_DENTS KB(32)
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+/* hints for io_map_file; they change when pages arrive, never what the
+   view holds, and a platform that can't take one ignores it */
+typedef U32 IoMapFlags;
+enum {
+  IoMapFlag_Sequential = (1 << 0),
+  IoMapFlag_WillNeed = (1 << 1),
+  IoMapFlag_HugePages = (1 << 2),
+};
+
+/* NoUring takes the thread pool even where io_uring works */
+typedef U32 IoBatchFlags;
+enum {
+  IoBatchFlag_NoUring = (1 << 0),
+};
+
+/* NoThread reads every chunk when it is asked for and only hints the
+   kernel to fetch the one after it */
+typedef U32 IoStreamFlags;
+enum {
+  IoStreamFlag_NoThread = (1 << 0),
+};
+
+/* Atomic writes next to the file and replaces it on close, so readers see
+   the old file or the whole new one. Direct skips the page cache where
+   the file system allows it */
+typedef U32 IoWriteFlags;
+enum {
+  IoWriteFlag_Atomic = (1 << 0),
+  IoWriteFlag_Direct = (1 << 1),
+};
+
+/* Hidden walks into and keeps names starting with a dot. Load reads every
+   file kept into the arena with io_load_files once the walk is done */
+typedef U32 IoScanFlags;
+enum {
+  IoScanFlag_Hidden = (1 << 0),
+  IoScanFlag_Load = (1 << 1),
+};
+
+/* one file of a batch. `data` has cstr 0 until the file is loaded and
+   when loading failed, `error` is then an errno (GetLastError on
+   Windows) */
+typedef struct IoLoad IoLoad;
+struct IoLoad {
+  CStr path;
+  Str8 data;
+  I32 error;
+};
+
+typedef Nothing (*IoLoadFn)(RawPtr user, IoLoad* load);
+
+#if defined(OS_LINUX)
+typedef struct IoRing IoRing;
+struct IoRing {
+  I32 fd;
+  U32 queued;
+  U32 in_flight;
+  U32* sq_head;
+  U32* sq_tail;
+  U32* sq_mask;
+  U32* sq_array;
+  U32* cq_head;
+  U32* cq_tail;
+  U32* cq_mask;
+  struct io_uring_sqe* sqes;
+  struct io_uring_cqe* cqes;
+  RawPtr sq_ring;
+  RawPtr cq_ring;
+  Sz sq_size;
+  Sz cq_size;
+  Sz sqes_size;
+};
+
+/* a file on its way through the ring: open and statx go out together,
+   then reads until the size statx gave, then close */
+typedef struct IoBatchSlot IoBatchSlot;
+struct IoBatchSlot {
+  U64 load;
+  I32 fd;
+  U32 pending;
+  I32 error;
+  U8* data;
+  U64 size;
+  U64 capacity;
+  struct statx st;
+};
+#endif /* OS_LINUX */
+
+/* `ready` lists loads in the order they finished and `consumed` how many
+   of those io_batch_next handed out. the pool's workers take loads by
+   bumping `next` and share `lock` for pushes to `a` and for `ready` */
+typedef struct IoBatch IoBatch;
+struct IoBatch {
+  Arena* a;
+  IoLoad* loads;
+  U64 count;
+  U64 next;
+  U32* ready;
+  U64 ready_count;
+  U64 consumed;
+  Bool uring;
+  PlatformMutex lock;
+  PlatformThread workers[IO_BATCH_THREADS];
+  U32 worker_count;
+#if defined(OS_LINUX)
+  IoRing ring;
+  IoBatchSlot* slots;
+  U32 free_slots[IO_BATCH_FILES];
+  U32 free_count;
+#endif /* OS_LINUX */
+};
+
+/* a file read front to back in `chunk` sized pieces through two buffers:
+   the caller parses the window in one while the next chunk is read into
+   the other. every buffer has `chunk` bytes in front of its chunk for
+   whatever the caller left of the window before, so a record cut by a
+   chunk boundary comes back whole. `last` is set on the window that ends
+   at the end of the file */
+typedef struct IoStream IoStream;
+struct IoStream {
+  U8* buffers[2];
+  U64 chunk;
+  U32 current;
+  Str8 window;
+  Bool last;
+  I32 error;
+  Bool threaded;
+  Bool reading;
+  PlatformThread reader;
+  U64 read_offset;
+  U64 read_size;
+  I32 read_error;
+#if defined(OS_WINDOWS)
+  HANDLE file;
+#else
+  I32 fd;
+#endif /* OS_WINDOWS */
+};
+
+/* writes collect in `buffer` until one doesn't fit, which then goes out
+   in the same writev as the buffer. `temp` is the file being written for
+   Atomic and 0 otherwise. `direct` is set when O_DIRECT (NO_BUFFERING on
+   Windows) took: only whole `block`s of the buffer go out then, and the
+   last one is padded and cut back to `total` on close. the first failure
+   sticks in `error` and whatever is written after it is dropped */
+typedef struct IoWriter IoWriter;
+struct IoWriter {
+  CStr path;
+  CStr temp;
+  CStr dir;
+  U8* buffer;
+  U64 capacity;
+  U64 size;
+  U64 total;
+  U64 block;
+  Bool direct;
+  I32 error;
+#if defined(OS_WINDOWS)
+  HANDLE file;
+#else
+  I32 fd;
+#endif /* OS_WINDOWS */
+};
+
+/* a regular file io_scan kept. `mtime` counts nanoseconds since the Unix
+   epoch; `data` and `error` are io_load_files' when the scan loads */
+typedef struct IoEntry IoEntry;
+struct IoEntry {
+  Str8 path;
+  U64 size;
+  U64 mtime;
+  Str8 data;
+  I32 error;
+};
+
+/* `error` is the first directory that couldn't be read; the walk goes on
+   past it */
+typedef struct IoScan IoScan;
+struct IoScan {
+  IoEntry* entries;
+  U64 count;
+  U64 directories;
+  I32 error;
+};
+
+#if defined(OS_LINUX)
+typedef struct IoDirent IoDirent;
+struct IoDirent {
+  U64 ino;
+  I64 off;
+  U16 reclen;
+  U8 type;
+  char name[];
+};
+#endif /* OS_LINUX */
+
+typedef struct IoScanChunk IoScanChunk;
+struct IoScanChunk {
+  IoScanChunk* next;
+  U64 count;
+  IoEntry entries[IO_SCAN_CHUNK];
+};
+
+/* one level of the tree at a time: workers take the level's `dirs` by
+   bumping `next`. paths are matched from `rel` on, past the root */
+typedef struct IoScanWalk IoScanWalk;
+struct IoScanWalk {
+  Str8 glob;
+  IoScanFlags flags;
+  U64 rel;
+  Str8* dirs;
+  U64 dir_count;
+  U64 next;
+};
+
+/* everything a worker finds stays in its own arena until the walk is
+   done; `dirs` are the ones it found for the next level */
+typedef struct IoScanWorker IoScanWorker;
+struct IoScanWorker {
+  IoScanWalk* walk;
+  Arena* a;
+  U8* dents;
+  IoScanChunk* first;
+  IoScanChunk* last;
+  U64 count;
+  Str8List dirs;
+  U64 directories;
+  I32 error;
+};
+
 /* ===================================================== */
 /*                          API                          */
 /* ===================================================== */
 
-MODULE SZ io_load_file(CSTR, BUF*);
+MODULE Sz io_load_file(CStr, Buf*);
+MODULE Str8 io_load_file_arena(Arena* a, CStr path);
+MODULE IoBatch* io_batch_begin(Arena* a, CStr* paths, U64 count,
+                               IoBatchFlags flags);
+MODULE IoLoad* io_batch_next(IoBatch* b, Bool wait);
+MODULE Bool io_batch_done(IoBatch* b);
+MODULE Nothing io_batch_end(IoBatch* b);
+MODULE IoLoad* io_load_files(Arena* a, CStr* paths, U64 count, IoBatchFlags flags,
+                             IoLoadFn fn, RawPtr user);
+MODULE IoStream* io_stream_open(Arena* a, CStr path, U64 chunk, IoStreamFlags flags);
+MODULE Str8 io_stream_next(IoStream* s, U64 consumed);
+MODULE Nothing io_stream_close(IoStream* s);
+MODULE IoWriter* io_writer_open(Arena* a, CStr path, U64 buffer, U64 reserve,
+                                IoWriteFlags flags);
+MODULE Nothing io_write(IoWriter* w, Str8 data);
+MODULE Nothing io_write_list(IoWriter* w, Str8List* list);
+MODULE Nothing io_writer_flush(IoWriter* w);
+MODULE I32 io_writer_close(IoWriter* w);
+MODULE IoScan io_scan(Arena* a, CStr root, Str8 glob, IoScanFlags flags, U32 threads);
+MODULE Str8 io_map_file(CStr path, IoMapFlags flags);
+MODULE Nothing io_unmap_file(Str8 view);
 
 /* ===================================================== */
 /*                    IMPLEMENTATION                     */
@@ -32,27 +340,1378 @@ MODULE SZ io_load_file(CSTR, BUF*);
 
 #ifdef SEPI_IO_IMPLEMENTATION
 
-MODULE SZ
-io_load_file(CSTR path, BUF* buf) {
+/* the whole file in a malloc'ed buffer the caller frees. `buf` is 0 and
+   the result 0 when the file can't be opened, sized or fully read */
+MODULE Sz
+io_load_file(CStr path, Buf* buf) {
+  *buf = 0;
   FILE* f = fopen(path, "rb");
-  NOTNULL(f);
+  if(!f) {
+    return 0;
+  }
 
-  fseek(f, 0, SEEK_END);
-  SZ fsize = ftell(f);
-  rewind(f);
+  long end = -1;
+  if(fseek(f, 0, SEEK_END) == 0) {
+    end = ftell(f);
+  }
+  Sz fsize = end < 0 ? 0 : (Sz)end;
+  Buf data = end < 0 ? 0 : (Buf)malloc(sizeof(U8) * Max(fsize, 1));
+  if(data) {
+    rewind(f);
+    if(fread(data, 1, fsize, f) == fsize) {
+      *buf = data;
+    } else {
+      free(data);
+    }
+  }
+  fclose(f);
+  return *buf ? fsize : 0;
+}
 
-  *buf = (BUF)malloc(sizeof(u8) * fsize);
-  NOTNULL(*buf);
+/* loads size the buffer one byte past what the file claims, so a file
+   that grew since shows up as a full buffer and gets a bigger one; a file
+   that shrank just reads fewer bytes. with a `lock` other threads push to
+   `a` as well, so pushes are taken under it */
+internal U8*
+io_load_push(Arena* a, PlatformMutex* lock, U64 size) {
+  if(lock) {
+    platform_mutex_lock(lock);
+  }
+  U8* result = arena_push_array_no_zero(a, U8, size);
+  if(lock) {
+    platform_mutex_unlock(lock);
+  }
+  return result;
+}
 
-  SZ rsize = fread(*buf, 1, fsize, f);
-  MAKESURE(rsize == fsize, "read size '%zu' did not match the file size '%zu'",
-           rsize, fsize);
+/* doubles in place while the buffer is the top of the arena, otherwise
+   moves to a new buffer and the old one stays behind */
+internal U8*
+io_load_grow(Arena* a, PlatformMutex* lock, U8* data, U64* capacity) {
+  if(lock) {
+    platform_mutex_lock(lock);
+  }
+  U64 position = arena_get_position(a);
+  U8* bigger = data;
+  if((U8*)arena_push(a, *capacity, 1, FALSE) != data + *capacity) {
+    arena_pop_to(a, position);
+    bigger = arena_push_array_no_zero(a, U8, *capacity * 2);
+  }
+  if(lock) {
+    platform_mutex_unlock(lock);
+  }
+  if(bigger != data) {
+    MemoryCopy(bigger, data, *capacity);
+  }
+  *capacity *= 2;
+  return bigger;
+}
+
+/* without a `lock` the unused tail is popped and a failed load leaves
+   nothing behind in `a`; with one, other threads' pushes may sit on top,
+   so nothing is popped */
+internal Nothing
+io_load_settle(Arena* a, PlatformMutex* lock, U64 position, U64 unused, Bool ok) {
+  if(lock) {
+    return;
+  }
+  if(ok) {
+    arena_pop(a, unused);
+  } else {
+    arena_pop_to(a, position);
+  }
+}
+
+/* a read-only view of the whole file. pages come straight from the page
+   cache on first touch, so nothing is copied and the file may be larger
+   than memory. cstr is 0 when the file can't be opened or mapped; an
+   empty file gives an empty view that is not 0 */
+#if defined(OS_LINUX) || defined(OS_MAC)
+
+MODULE Str8
+io_map_file(CStr path, IoMapFlags flags) {
+  Str8 result = {0};
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    return result;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    Sz size = (Sz)st.st_size;
+    RawPtr view = size ? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0) : (RawPtr)"";
+    if(view != MAP_FAILED) {
+      if(size && (flags & IoMapFlag_Sequential)) {
+        madvise(view, size, MADV_SEQUENTIAL);
+      }
+      if(size && (flags & IoMapFlag_WillNeed)) {
+        madvise(view, size, MADV_WILLNEED);
+      }
+#if defined(MADV_HUGEPAGE)
+      if(size && (flags & IoMapFlag_HugePages)) {
+        madvise(view, size, MADV_HUGEPAGE);
+      }
+#endif /* MADV_HUGEPAGE */
+      result = str8_raw(view, size);
+    }
+  }
+
+  close(fd);
+  return result;
+}
+
+MODULE Nothing
+io_unmap_file(Str8 view) {
+  if(view.size) {
+    munmap((RawPtr)view.cstr, view.size);
+  }
+}
+
+internal Str8
+io_load_path(Arena* a, PlatformMutex* lock, CStr path, I32* error) {
+  Str8 result = {0};
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    *error = errno;
+    return result;
+  }
+
+  U64 position = lock ? 0 : arena_get_position(a);
+  struct stat st;
+  Bool ok = fstat(fd, &st) == 0;
+  *error = !ok ? errno : S_ISDIR(st.st_mode) ? EISDIR : S_ISREG(st.st_mode) ? 0 : EINVAL;
+  ok = *error == 0;
+  U64 capacity = ok ? (U64)st.st_size + 1 : 0;
+  U8* data = ok ? io_load_push(a, lock, capacity) : 0;
+  U64 size = 0;
+  while(ok) {
+    if(size == capacity) {
+      data = io_load_grow(a, lock, data, &capacity);
+    }
+    ssize_t got = pread(fd, data + size, Min(capacity - size, IO_READ_CHUNK),
+                        (off_t)size);
+    if(got > 0) {
+      size += (U64)got;
+    } else if(got == 0) {
+      break;
+    } else if(errno != EINTR) {
+      *error = errno;
+      ok = FALSE;
+    }
+  }
+  close(fd);
 
-  if(f) {
-    fclose(f);
+  io_load_settle(a, lock, position, capacity - size, ok);
+  if(ok) {
+    result = str8_raw(data, size);
   }
+  return result;
+}
+
+#else /* OS_WINDOWS */
+
+MODULE Str8
+io_map_file(CStr path, IoMapFlags flags) {
+  Str8 result = {0};
+  DWORD attributes = flags & IoMapFlag_Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+                     : FILE_ATTRIBUTE_NORMAL;
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                            attributes, 0);
+  if(file == INVALID_HANDLE_VALUE) {
+    return result;
+  }
+
+  LARGE_INTEGER size = {0};
+  Bool sized = GetFileSizeEx(file, &size) != 0;
+  if(sized && size.QuadPart == 0) {
+    result = str8_raw((RawPtr)"", 0);
+  } else if(sized) {
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    RawPtr view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    if(view) {
+      if(flags & IoMapFlag_WillNeed) {
+        WIN32_MEMORY_RANGE_ENTRY range = {view, (Sz)size.QuadPart};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+      }
+      result = str8_raw(view, (Sz)size.QuadPart);
+    }
+    if(mapping) {
+      CloseHandle(mapping);
+    }
+  }
+
+  CloseHandle(file);
+  return result;
+}
+
+MODULE Nothing
+io_unmap_file(Str8 view) {
+  if(view.size) {
+    UnmapViewOfFile(view.cstr);
+  }
+}
+
+internal Str8
+io_load_path(Arena* a, PlatformMutex* lock, CStr path, I32* error) {
+  Str8 result = {0};
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if(file == INVALID_HANDLE_VALUE) {
+    *error = (I32)GetLastError();
+    return result;
+  }
+
+  U64 position = lock ? 0 : arena_get_position(a);
+  LARGE_INTEGER file_size = {0};
+  Bool ok = GetFileSizeEx(file, &file_size) != 0;
+  U64 capacity = ok ? (U64)file_size.QuadPart + 1 : 0;
+  U8* data = ok ? io_load_push(a, lock, capacity) : 0;
+  U64 size = 0;
+  while(ok) {
+    if(size == capacity) {
+      data = io_load_grow(a, lock, data, &capacity);
+    }
+    OVERLAPPED at = {0};
+    at.Offset = (DWORD)size;
+    at.OffsetHigh = (DWORD)(size >> 32);
+    DWORD got = 0;
+    ok = ReadFile(file, data + size, (DWORD)Min(capacity - size, IO_READ_CHUNK), &got,
+                  &at) != 0 || GetLastError() == ERROR_HANDLE_EOF;
+    if(got == 0) {
+      break;
+    }
+    size += got;
+  }
+  *error = ok ? 0 : (I32)GetLastError();
+  CloseHandle(file);
+
+  io_load_settle(a, lock, position, capacity - size, ok);
+  if(ok) {
+    result = str8_raw(data, size);
+  }
+  return result;
+}
+
+#endif /* OS_LINUX || OS_MAC */
 
-  return fsize;
+MODULE Str8
+io_load_file_arena(Arena* a, CStr path) {
+  I32 error = 0;
+  return io_load_path(a, 0, path, &error);
+}
+
+#if defined(OS_LINUX)
+
+typedef U32 IoRingOp;
+enum {
+  IoRingOp_Open,
+  IoRingOp_Statx,
+  IoRingOp_Read,
+  IoRingOp_Close,
+};
+
+/* FALSE when io_uring is missing, disallowed, or too old for the four
+   operations a batch needs */
+internal Bool
+io_ring_init(IoRing* r, U32 entries) {
+  struct io_uring_params params;
+  MemZeroStruct(&params);
+  MemZeroStruct(r);
+  r->fd = (I32)syscall(__NR_io_uring_setup, entries, &params);
+  if(r->fd < 0) {
+    return FALSE;
+  }
+
+  U64 probe_buffer[(sizeof(struct io_uring_probe) +
+                    256 * sizeof(struct io_uring_probe_op)) / sizeof(U64) + 1];
+  struct io_uring_probe* probe = (struct io_uring_probe*)probe_buffer;
+  U8 ops[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE};
+  MemZeroArray(probe_buffer);
+  Bool ok = syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+  for(U64 i = 0; ok && i < ArrayCount(ops); ++i) {
+    ok = ops[i] <= probe->last_op && (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+  }
+
+  r->sq_size = params.sq_off.array + params.sq_entries * sizeof(U32);
+  r->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  r->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  if(params.features & IORING_FEAT_SINGLE_MMAP) {
+    r->sq_size = r->cq_size = Max(r->sq_size, r->cq_size);
+  }
+  r->sq_ring = r->cq_ring = r->sqes = MAP_FAILED;
+  if(ok) {
+    r->sq_ring = mmap(0, r->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      r->fd, IORING_OFF_SQ_RING);
+    r->cq_ring = params.features & IORING_FEAT_SINGLE_MMAP ? r->sq_ring
+                 : mmap(0, r->cq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    r->sqes = mmap(0, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   r->fd, IORING_OFF_SQES);
+  }
+  if(r->sq_ring == MAP_FAILED || r->cq_ring == MAP_FAILED || r->sqes == MAP_FAILED) {
+    if(r->sqes != MAP_FAILED) {
+      munmap(r->sqes, r->sqes_size);
+    }
+    if(r->cq_ring != MAP_FAILED && r->cq_ring != r->sq_ring) {
+      munmap(r->cq_ring, r->cq_size);
+    }
+    if(r->sq_ring != MAP_FAILED) {
+      munmap(r->sq_ring, r->sq_size);
+    }
+    close(r->fd);
+    return FALSE;
+  }
+
+  U8* sq = (U8*)r->sq_ring;
+  U8* cq = (U8*)r->cq_ring;
+  r->sq_head = (U32*)(sq + params.sq_off.head);
+  r->sq_tail = (U32*)(sq + params.sq_off.tail);
+  r->sq_mask = (U32*)(sq + params.sq_off.ring_mask);
+  r->sq_array = (U32*)(sq + params.sq_off.array);
+  r->cq_head = (U32*)(cq + params.cq_off.head);
+  r->cq_tail = (U32*)(cq + params.cq_off.tail);
+  r->cq_mask = (U32*)(cq + params.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  return TRUE;
+}
+
+internal Nothing
+io_ring_release(IoRing* r) {
+  munmap(r->sqes, r->sqes_size);
+  if(r->cq_ring != r->sq_ring) {
+    munmap(r->cq_ring, r->cq_size);
+  }
+  munmap(r->sq_ring, r->sq_size);
+  close(r->fd);
+}
+
+/* the ring is only ever fed from one thread, so the tail needs no more
+   than a release store for the kernel to see the entry */
+internal struct io_uring_sqe*
+io_ring_push(IoRing* r, U8 opcode, I32 fd, U64 addr, U32 len, U64 off, U64 tag) {
+  U32 tail = *r->sq_tail;
+  U32 index = tail & *r->sq_mask;
+  struct io_uring_sqe* sqe = &r->sqes[index];
+  MemZeroStruct(sqe);
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = addr;
+  sqe->len = len;
+  sqe->off = off;
+  sqe->user_data = tag;
+  r->sq_array[index] = index;
+  __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  r->queued += 1;
+  r->in_flight += 1;
+  return sqe;
+}
+
+internal Nothing
+io_ring_enter(IoRing* r, Bool wait) {
+  I32 submitted = (I32)syscall(__NR_io_uring_enter, r->fd, r->queued, wait ? 1 : 0,
+                               wait ? IORING_ENTER_GETEVENTS : 0, 0, 0);
+  if(submitted > 0) {
+    r->queued -= (U32)submitted;
+  }
+}
+
+internal U64
+io_batch_tag(U32 slot, IoRingOp op) {
+  return ((U64)slot << 2) | op;
+}
+
+internal Nothing
+io_batch_ring_read(IoBatch* b, U32 s) {
+  IoBatchSlot* slot = &b->slots[s];
+  if(slot->size == slot->capacity) {
+    slot->data = io_load_grow(b->a, 0, slot->data, &slot->capacity);
+  }
+  io_ring_push(&b->ring, IORING_OP_READ, slot->fd, (U64)(slot->data + slot->size),
+               (U32)Min(slot->capacity - slot->size, IO_READ_CHUNK), slot->size,
+               io_batch_tag(s, IoRingOp_Read));
+}
+
+internal Nothing
+io_batch_ring_finish(IoBatch* b, U32 s) {
+  IoBatchSlot* slot = &b->slots[s];
+  IoLoad* load = &b->loads[slot->load];
+  if(slot->fd >= 0) {
+    io_ring_push(&b->ring, IORING_OP_CLOSE, slot->fd, 0, 0, 0,
+                 io_batch_tag(s, IoRingOp_Close));
+  }
+  load->error = slot->error;
+  if(!slot->error) {
+    load->data = str8_raw(slot->data, slot->size);
+  }
+  b->ready[b->ready_count++] = (U32)slot->load;
+  b->free_slots[b->free_count++] = s;
+}
+
+/* a read that stops short of the size statx gave, or fills the buffer,
+   is followed by another; one that comes back empty ends the file */
+internal Nothing
+io_batch_ring_complete(IoBatch* b, U64 tag, I32 result) {
+  U32 s = (U32)(tag >> 2);
+  IoRingOp op = (IoRingOp)(tag & 3);
+  IoBatchSlot* slot = &b->slots[s];
+  b->ring.in_flight -= 1;
+
+  if(op == IoRingOp_Open || op == IoRingOp_Statx) {
+    if(result < 0 && !slot->error) {
+      slot->error = -result;
+    } else if(op == IoRingOp_Open && result >= 0) {
+      slot->fd = result;
+    }
+    if(--slot->pending) {
+      return;
+    }
+    if(!slot->error && !S_ISREG(slot->st.stx_mode)) {
+      slot->error = S_ISDIR(slot->st.stx_mode) ? EISDIR : EINVAL;
+    }
+    if(slot->error) {
+      io_batch_ring_finish(b, s);
+      return;
+    }
+    slot->capacity = slot->st.stx_size + 1;
+    slot->data = arena_push_array_no_zero(b->a, U8, slot->capacity);
+    io_batch_ring_read(b, s);
+  } else if(op == IoRingOp_Read) {
+    if(result == -EINTR || result == -EAGAIN) {
+      io_batch_ring_read(b, s);
+    } else if(result < 0) {
+      slot->error = -result;
+      io_batch_ring_finish(b, s);
+    } else {
+      slot->size += (U64)result;
+      if(result && (slot->size == slot->capacity || slot->size < slot->st.stx_size)) {
+        io_batch_ring_read(b, s);
+      } else {
+        io_batch_ring_finish(b, s);
+      }
+    }
+  }
+}
+
+/* open and statx of a file go out together, both by path */
+internal Nothing
+io_batch_ring_start(IoBatch* b) {
+  while(b->free_count && b->next < b->count) {
+    U32 s = b->free_slots[--b->free_count];
+    IoBatchSlot* slot = &b->slots[s];
+    MemZeroStruct(slot);
+    slot->load = b->next++;
+    slot->fd = -1;
+    slot->pending = 2;
+    U64 path = (U64)b->loads[slot->load].path;
+    io_ring_push(&b->ring, IORING_OP_OPENAT, AT_FDCWD, path, 0, 0,
+                 io_batch_tag(s, IoRingOp_Open))->open_flags = O_RDONLY | O_CLOEXEC;
+    io_ring_push(&b->ring, IORING_OP_STATX, AT_FDCWD, path, STATX_TYPE | STATX_SIZE,
+                 (U64)&slot->st, io_batch_tag(s, IoRingOp_Statx));
+  }
+}
+
+internal Nothing
+io_batch_ring_reap(IoBatch* b) {
+  IoRing* r = &b->ring;
+  U32 head = *r->cq_head;
+  U32 tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+  for(; head != tail; ++head) {
+    struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+    io_batch_ring_complete(b, cqe->user_data, cqe->res);
+  }
+  __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+}
+
+#endif /* OS_LINUX */
+
+internal Nothing
+io_batch_load(IoBatch* b, U64 i) {
+  IoLoad* load = &b->loads[i];
+  load->data = io_load_path(b->a, &b->lock, load->path, &load->error);
+  platform_mutex_lock(&b->lock);
+  b->ready[b->ready_count++] = (U32)i;
+  platform_mutex_unlock(&b->lock);
+}
+
+internal Nothing
+io_batch_worker(RawPtr arg) {
+  IoBatch* b = (IoBatch*)arg;
+  for(U64 i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED); i < b->count;
+      i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) {
+    io_batch_load(b, i);
+  }
+}
+
+internal Nothing
+io_batch_join(IoBatch* b) {
+  for(U32 t = 0; t < b->worker_count; ++t) {
+    platform_thread_join(&b->workers[t]);
+  }
+  b->worker_count = 0;
+}
+
+/* everything, loaded files included, lands in `a`, which nobody else may
+   push to until io_batch_end. io_uring runs the whole batch from the
+   calling thread, IO_BATCH_FILES files at a time; without it a pool of
+   workers loads files with io_load_file_arena's reader */
+MODULE IoBatch*
+io_batch_begin(Arena* a, CStr* paths, U64 count, IoBatchFlags flags) {
+  IoBatch* b = arena_push_array(a, IoBatch, 1);
+  b->a = a;
+  b->count = count;
+  b->loads = arena_push_array(a, IoLoad, count);
+  b->ready = arena_push_array_no_zero(a, U32, count);
+  for(U64 i = 0; i < count; ++i) {
+    b->loads[i].path = paths[i];
+  }
+
+#if defined(OS_LINUX)
+  if(!(flags & IoBatchFlag_NoUring) && count && io_ring_init(&b->ring, IO_BATCH_DEPTH)) {
+    b->uring = TRUE;
+    b->slots = arena_push_array(a, IoBatchSlot, IO_BATCH_FILES);
+    for(U32 s = 0; s < IO_BATCH_FILES; ++s) {
+      b->free_slots[b->free_count++] = IO_BATCH_FILES - 1 - s;
+    }
+    return b;
+  }
+#else
+  Ignore(flags);
+#endif /* OS_LINUX */
+
+  platform_mutex_init(&b->lock);
+  U32 workers = (U32)Min(IO_BATCH_THREADS, count);
+  for(; b->worker_count < workers; ++b->worker_count) {
+    if(!platform_thread_start(&b->workers[b->worker_count], io_batch_worker, b)) {
+      break;
+    }
+  }
+  return b;
+}
+
+/* the next load to finish, in completion order. without `wait` it is 0
+   when none is ready yet; with it, 0 only once every load was handed
+   out. a waiting caller of the pool loads files itself rather than
+   sleep */
+MODULE IoLoad*
+io_batch_next(IoBatch* b, Bool wait) {
+  while(b->consumed < b->count) {
+#if defined(OS_LINUX)
+    if(b->uring) {
+      if(b->consumed < b->ready_count) {
+        return &b->loads[b->ready[b->consumed++]];
+      }
+      io_batch_ring_start(b);
+      io_ring_enter(&b->ring, wait);
+      io_batch_ring_reap(b);
+      if(!wait && b->consumed == b->ready_count) {
+        return 0;
+      }
+      continue;
+    }
+#endif /* OS_LINUX */
+
+    platform_mutex_lock(&b->lock);
+    IoLoad* load = b->consumed < b->ready_count ? &b->loads[b->ready[b->consumed++]] : 0;
+    platform_mutex_unlock(&b->lock);
+    if(load || !wait) {
+      return load;
+    }
+    U64 i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED);
+    if(i < b->count) {
+      io_batch_load(b, i);
+    } else {
+      io_batch_join(b);
+    }
+  }
+  return 0;
+}
+
+MODULE Bool
+io_batch_done(IoBatch* b) {
+  return b->consumed == b->count;
+}
+
+/* loads nobody asked for are still finished first, so no read is left
+   writing into `a` */
+MODULE Nothing
+io_batch_end(IoBatch* b) {
+  while(io_batch_next(b, TRUE)) {
+  }
+#if defined(OS_LINUX)
+  if(b->uring) {
+    while(b->ring.in_flight) {
+      io_ring_enter(&b->ring, TRUE);
+      io_batch_ring_reap(b);
+    }
+    io_ring_release(&b->ring);
+    return;
+  }
+#endif /* OS_LINUX */
+  io_batch_join(b);
+  platform_mutex_destroy(&b->lock);
+}
+
+/* runs a whole batch, calling `fn` on the calling thread as every file
+   finishes, and returns the loads in the order of `paths` */
+MODULE IoLoad*
+io_load_files(Arena* a, CStr* paths, U64 count, IoBatchFlags flags, IoLoadFn fn,
+              RawPtr user) {
+  IoBatch* b = io_batch_begin(a, paths, count, flags);
+  for(IoLoad* load = io_batch_next(b, TRUE); load; load = io_batch_next(b, TRUE)) {
+    if(fn) {
+      fn(user, load);
+    }
+  }
+  io_batch_end(b);
+  return b->loads;
+}
+
+/* a read thread owns `read_*` and the buffer that isn't current until it
+   is joined. a chunk is only short at the end of the file */
+#if defined(OS_LINUX) || defined(OS_MAC)
+
+internal Nothing
+io_stream_read(RawPtr arg) {
+  IoStream* s = (IoStream*)arg;
+  U8* data = s->buffers[s->current ^ 1] + s->chunk;
+  s->read_size = 0;
+  s->read_error = 0;
+  while(s->read_size < s->chunk) {
+    ssize_t got = pread(s->fd, data + s->read_size,
+                        Min(s->chunk - s->read_size, IO_READ_CHUNK),
+                        (off_t)(s->read_offset + s->read_size));
+    if(got > 0) {
+      s->read_size += (U64)got;
+    } else if(got == 0) {
+      break;
+    } else if(errno != EINTR) {
+      s->read_error = errno;
+      break;
+    }
+  }
+}
+
+internal Bool
+io_stream_file(IoStream* s, CStr path) {
+  s->fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(s->fd < 0) {
+    return FALSE;
+  }
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(s->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif /* POSIX_FADV_SEQUENTIAL */
+  return TRUE;
+}
+
+internal Nothing
+io_stream_hint(IoStream* s) {
+#if defined(POSIX_FADV_WILLNEED)
+  posix_fadvise(s->fd, (off_t)s->read_offset, (off_t)s->chunk, POSIX_FADV_WILLNEED);
+#else
+  Ignore(s);
+#endif /* POSIX_FADV_WILLNEED */
+}
+
+internal Nothing
+io_stream_file_close(IoStream* s) {
+  close(s->fd);
+}
+
+#else /* OS_WINDOWS */
+
+internal Nothing
+io_stream_read(RawPtr arg) {
+  IoStream* s = (IoStream*)arg;
+  U8* data = s->buffers[s->current ^ 1] + s->chunk;
+  s->read_size = 0;
+  s->read_error = 0;
+  while(s->read_size < s->chunk) {
+    U64 offset = s->read_offset + s->read_size;
+    OVERLAPPED at = {0};
+    at.Offset = (DWORD)offset;
+    at.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD got = 0;
+    if(!ReadFile(s->file, data + s->read_size,
+                 (DWORD)Min(s->chunk - s->read_size, IO_READ_CHUNK), &got, &at) &&
+       GetLastError() != ERROR_HANDLE_EOF) {
+      s->read_error = (I32)GetLastError();
+      break;
+    }
+    if(got == 0) {
+      break;
+    }
+    s->read_size += got;
+  }
+}
+
+internal Bool
+io_stream_file(IoStream* s, CStr path) {
+  s->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  return s->file != INVALID_HANDLE_VALUE;
+}
+
+/* FILE_FLAG_SEQUENTIAL_SCAN already reads ahead */
+internal Nothing
+io_stream_hint(IoStream* s) {
+  Ignore(s);
+}
+
+internal Nothing
+io_stream_file_close(IoStream* s) {
+  CloseHandle(s->file);
+}
+
+#endif /* OS_LINUX || OS_MAC */
+
+/* the next chunk goes to a read thread, or inline when one can't start */
+internal Nothing
+io_stream_fetch(IoStream* s) {
+  s->reading = TRUE;
+  if(!s->threaded || !platform_thread_start(&s->reader, io_stream_read, s)) {
+    io_stream_read(s);
+    s->reading = FALSE;
+  }
+}
+
+internal Nothing
+io_stream_wait(IoStream* s) {
+  if(s->reading) {
+    platform_thread_join(&s->reader);
+    s->reading = FALSE;
+  }
+}
+
+/* 0 when the file can't be opened. with threads the first chunk is
+   already being read when this returns */
+MODULE IoStream*
+io_stream_open(Arena* a, CStr path, U64 chunk, IoStreamFlags flags) {
+  U64 position = arena_get_position(a);
+  IoStream* s = arena_push_array(a, IoStream, 1);
+  if(!io_stream_file(s, path)) {
+    arena_pop_to(a, position);
+    return 0;
+  }
+  s->chunk = chunk ? chunk : IO_STREAM_CHUNK;
+  s->buffers[0] = arena_push_array_no_zero(a, U8, s->chunk * 2);
+  s->buffers[1] = arena_push_array_no_zero(a, U8, s->chunk * 2);
+  s->window = str8_raw(s->buffers[0] + s->chunk, 0);
+  s->threaded = !(flags & IoStreamFlag_NoThread);
+  if(s->threaded) {
+    io_stream_fetch(s);
+  } else {
+    io_stream_hint(s);
+  }
+  return s;
+}
+
+/* the window after the first `consumed` bytes of the one before, which is
+   no longer valid: what is left of it comes first, then the next chunk.
+   the window is empty once the file is done or `error` is set; a caller
+   that leaves more than a chunk unconsumed gets EOVERFLOW */
+MODULE Str8
+io_stream_next(IoStream* s, U64 consumed) {
+  U64 carry = s->window.size - Min(consumed, s->window.size);
+  if(s->last || s->error) {
+    s->window.size = 0;
+    return s->window;
+  }
+  if(carry > s->chunk) {
+    io_stream_wait(s);
+    s->error = EOVERFLOW;
+    s->window.size = 0;
+    return s->window;
+  }
+
+  if(s->threaded) {
+    io_stream_wait(s);
+  } else {
+    io_stream_fetch(s);
+  }
+  U8* next = s->buffers[s->current ^ 1] + s->chunk;
+  memmove(next - carry, s->window.cstr + s->window.size - carry, carry);
+  s->window = str8_raw(next - carry, carry + s->read_size);
+  s->error = s->read_error;
+  s->last = s->read_size < s->chunk;
+  s->current ^= 1;
+  s->read_offset += s->read_size;
+
+  if(s->error) {
+    s->window.size = 0;
+  } else if(!s->last) {
+    if(s->threaded) {
+      io_stream_fetch(s);
+    } else {
+      io_stream_hint(s);
+    }
+  }
+  return s->window;
+}
+
+/* the buffers stay in the arena; this only waits for the read in flight
+   and closes the file */
+MODULE Nothing
+io_stream_close(IoStream* s) {
+  io_stream_wait(s);
+  io_stream_file_close(s);
+}
+
+internal U64 io_writer_temps;
+
+#if defined(OS_LINUX) || defined(OS_MAC)
+
+/* `reserve` is only a hint: blocks are allocated up front where the file
+   system can, without changing the size of the file */
+internal Bool
+io_writer_file(IoWriter* w, U64 reserve, IoWriteFlags flags) {
+  CStr target = w->temp ? w->temp : w->path;
+  w->fd = open(target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | (w->temp ? O_EXCL : 0),
+               0666);
+  if(w->fd < 0) {
+    return FALSE;
+  }
+#if defined(OS_LINUX)
+  if(flags & IoWriteFlag_Direct) {
+    I32 status = fcntl(w->fd, F_GETFL);
+    w->direct = status >= 0 && fcntl(w->fd, F_SETFL, status | O_DIRECT) == 0;
+  }
+#if defined(CPU_X64) || defined(CPU_ARM64)
+  if(reserve) {
+    syscall(SYS_fallocate, w->fd, FALLOC_FL_KEEP_SIZE, (off_t)0, (off_t)reserve);
+  }
+#endif /* CPU_X64 || CPU_ARM64 */
+#else /* OS_MAC */
+  if(flags & IoWriteFlag_Direct) {
+    fcntl(w->fd, F_NOCACHE, 1);
+  }
+  if(reserve) {
+    fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)reserve, 0};
+    fcntl(w->fd, F_PREALLOCATE, &store);
+  }
+#endif /* OS_LINUX */
+  return TRUE;
+}
+
+internal Nothing
+io_writer_gather(IoWriter* w, Str8* pieces, U64 count) {
+  struct iovec v[IO_WRITE_PIECES];
+  U64 n = 0;
+  for(U64 i = 0; i < count; ++i) {
+    if(pieces[i].size) {
+      v[n].iov_base = (RawPtr)pieces[i].cstr;
+      v[n].iov_len = pieces[i].size;
+      n += 1;
+    }
+  }
+  U64 at = 0;
+  while(!w->error && at < n) {
+    ssize_t done = writev(w->fd, v + at, (int)(n - at));
+    if(done < 0) {
+      w->error = errno == EINTR ? 0 : errno;
+      continue;
+    }
+    while(at < n && (U64)done >= v[at].iov_len) {
+      done -= (ssize_t)v[at].iov_len;
+      at += 1;
+    }
+    if(at < n) {
+      v[at].iov_base = (U8*)v[at].iov_base + done;
+      v[at].iov_len -= (Sz)done;
+    }
+  }
+}
+
+/* the rename only survives a crash once the directory is synced too */
+internal Nothing
+io_writer_finish(IoWriter* w) {
+  if(!w->error && w->direct && ftruncate(w->fd, (off_t)w->total) != 0) {
+    w->error = errno;
+  }
+  if(!w->error && w->temp && fsync(w->fd) != 0) {
+    w->error = errno;
+  }
+  if(close(w->fd) != 0 && !w->error) {
+    w->error = errno;
+  }
+  if(!w->temp) {
+    return;
+  }
+  if(!w->error && rename(w->temp, w->path) != 0) {
+    w->error = errno;
+  }
+  if(w->error) {
+    unlink(w->temp);
+    return;
+  }
+  int dir = open(w->dir, O_RDONLY | O_CLOEXEC);
+  if(dir >= 0) {
+    fsync(dir);
+    close(dir);
+  }
+}
+
+#else /* OS_WINDOWS */
+
+internal Bool
+io_writer_file(IoWriter* w, U64 reserve, IoWriteFlags flags) {
+  CStr target = w->temp ? w->temp : w->path;
+  DWORD attributes = flags & IoWriteFlag_Direct ? FILE_FLAG_NO_BUFFERING
+                     : FILE_ATTRIBUTE_NORMAL;
+  w->file = CreateFileA(target, GENERIC_WRITE, 0, 0, w->temp ? CREATE_NEW : CREATE_ALWAYS,
+                        attributes, 0);
+  if(w->file == INVALID_HANDLE_VALUE) {
+    return FALSE;
+  }
+  w->direct = (flags & IoWriteFlag_Direct) != 0;
+  if(reserve) {
+    FILE_ALLOCATION_INFO info = {0};
+    info.AllocationSize.QuadPart = (LONGLONG)reserve;
+    SetFileInformationByHandle(w->file, FileAllocationInfo, &info, sizeof(info));
+  }
+  return TRUE;
+}
+
+internal Nothing
+io_writer_gather(IoWriter* w, Str8* pieces, U64 count) {
+  for(U64 i = 0; i < count; ++i) {
+    for(U64 at = 0; !w->error && at < pieces[i].size;) {
+      DWORD done = 0;
+      if(!WriteFile(w->file, pieces[i].cstr + at, (DWORD)Min(pieces[i].size - at, GB(1)),
+                    &done, 0)) {
+        w->error = (I32)GetLastError();
+      }
+      at += done;
+    }
+  }
+}
+
+internal Nothing
+io_writer_finish(IoWriter* w) {
+  if(!w->error && w->direct) {
+    LARGE_INTEGER end = {0};
+    end.QuadPart = (LONGLONG)w->total;
+    if(!SetFilePointerEx(w->file, end, 0, FILE_BEGIN) || !SetEndOfFile(w->file)) {
+      w->error = (I32)GetLastError();
+    }
+  }
+  if(!w->error && w->temp && !FlushFileBuffers(w->file)) {
+    w->error = (I32)GetLastError();
+  }
+  CloseHandle(w->file);
+  if(!w->temp) {
+    return;
+  }
+  if(!w->error && !MoveFileExA(w->temp, w->path,
+                               MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    w->error = (I32)GetLastError();
+  }
+  if(w->error) {
+    DeleteFileA(w->temp);
+  }
+}
+
+#endif /* OS_LINUX || OS_MAC */
+
+/* whole blocks of the buffer go out and the rest moves to its front; the
+   bytes are let go of even when writing failed */
+internal Nothing
+io_writer_drain(IoWriter* w) {
+  U64 out = w->direct ? AlignDown(w->size, w->block) : w->size;
+  Str8 piece = str8_raw(w->buffer, out);
+  io_writer_gather(w, &piece, 1);
+  memmove(w->buffer, w->buffer + out, w->size - out);
+  w->size -= out;
+}
+
+/* 0 when the file can't be created. an Atomic writer's file is named
+   after `path`, the process and a counter, so two of them never share
+   one */
+MODULE IoWriter*
+io_writer_open(Arena* a, CStr path, U64 buffer, U64 reserve, IoWriteFlags flags) {
+  U64 position = arena_get_position(a);
+  IoWriter* w = arena_push_array(a, IoWriter, 1);
+  w->path = path;
+  if(flags & IoWriteFlag_Atomic) {
+    U64 temp = __atomic_fetch_add(&io_writer_temps, 1, __ATOMIC_RELAXED);
+#if defined(OS_WINDOWS)
+    U64 process = GetCurrentProcessId();
+#else
+    U64 process = (U64)getpid();
+#endif /* OS_WINDOWS */
+    w->temp = str8f(a, "%s.%llu.%llu.tmp", path, (unsigned long long)process,
+                    (unsigned long long)temp).cstr;
+    CStr slash = strrchr(path, '/');
+    w->dir = slash ? str8f(a, "%.*s", (int)Max(1, slash - path), path).cstr : ".";
+  }
+  if(!io_writer_file(w, reserve, flags)) {
+    arena_pop_to(a, position);
+    return 0;
+  }
+  w->block = platform_get_page_size();
+  w->capacity = AlignUp(buffer ? buffer : IO_WRITE_BUFFER, w->block);
+  w->buffer = arena_push_array_no_zero_aligned(a, U8, w->capacity, w->block);
+  return w;
+}
+
+MODULE Nothing
+io_write(IoWriter* w, Str8 data) {
+  if(!data.size) {
+    return;
+  }
+  w->total += data.size;
+  if(w->size + data.size <= w->capacity) {
+    MemoryCopy(w->buffer + w->size, data.cstr, data.size);
+    w->size += data.size;
+    return;
+  }
+  if(!w->direct) {
+    Str8 pieces[2] = {str8_raw(w->buffer, w->size), data};
+    io_writer_gather(w, pieces, ArrayCount(pieces));
+    w->size = 0;
+    return;
+  }
+  /* direct writes need block aligned memory, so everything goes through
+     the buffer */
+  for(U64 at = 0; at < data.size;) {
+    U64 n = Min(w->capacity - w->size, data.size - at);
+    MemoryCopy(w->buffer + w->size, data.cstr + at, n);
+    w->size += n;
+    at += n;
+    if(w->size == w->capacity) {
+      io_writer_drain(w);
+    }
+  }
+}
+
+/* pieces that fit in the buffer are copied; otherwise they go out where
+   they are, IO_WRITE_PIECES to a writev */
+MODULE Nothing
+io_write_list(IoWriter* w, Str8List* list) {
+  if(w->direct || w->size + list->total_size <= w->capacity) {
+    for(Str8Node* n = list->first; n; n = n->next) {
+      io_write(w, n->string);
+    }
+    return;
+  }
+  Str8 pieces[IO_WRITE_PIECES];
+  U64 count = 0;
+  pieces[count++] = str8_raw(w->buffer, w->size);
+  for(Str8Node* n = list->first; n; n = n->next) {
+    if(count == ArrayCount(pieces)) {
+      io_writer_gather(w, pieces, count);
+      count = 0;
+    }
+    pieces[count++] = n->string;
+    w->total += n->string.size;
+  }
+  io_writer_gather(w, pieces, count);
+  w->size = 0;
+}
+
+/* a direct writer keeps the part of its buffer past the last whole block */
+MODULE Nothing
+io_writer_flush(IoWriter* w) {
+  io_writer_drain(w);
+}
+
+/* 0 once every byte is in the file and, for Atomic, the file replaced
+   `path`; otherwise the error, and an Atomic `path` is left as it was */
+MODULE I32
+io_writer_close(IoWriter* w) {
+  if(w->direct) {
+    U64 pad = AlignUpPad(w->size, w->block);
+    memset(w->buffer + w->size, 0, pad);
+    w->size += pad;
+  }
+  io_writer_drain(w);
+  io_writer_finish(w);
+  return w->error;
+}
+
+internal Str8
+io_scan_join(Arena* a, Str8 dir, CStr name) {
+  U64 slash = dir.size && dir.cstr[dir.size - 1] != '/';
+  U64 name_size = strlen(name);
+  U8* path = arena_push_array_no_zero(a, U8, dir.size + slash + name_size + 1);
+  MemoryCopy(path, dir.cstr, dir.size);
+  path[dir.size] = '/';
+  MemoryCopy(path + dir.size + slash, name, name_size + 1);
+  return str8_raw(path, dir.size + slash + name_size);
+}
+
+internal Bool
+io_scan_skip(IoScanWorker* w, CStr name) {
+  return name[0] == '.' && (!(w->walk->flags & IoScanFlag_Hidden) || name[1] == 0 ||
+                            (name[1] == '.' && name[2] == 0));
+}
+
+internal Nothing
+io_scan_fail(IoScanWorker* w, I32 error) {
+  if(!w->error) {
+    w->error = error;
+  }
+}
+
+/* FALSE leaves nothing behind in the worker's arena */
+internal Bool
+io_scan_match(IoScanWorker* w, Str8 dir, CStr name, Str8* path) {
+  U64 position = arena_get_position(w->a);
+  *path = io_scan_join(w->a, dir, name);
+  Str8 rel = str8_raw((U8*)path->cstr + w->walk->rel, path->size - w->walk->rel);
+  if(w->walk->glob.size && !str8_glob(rel, w->walk->glob, 0)) {
+    arena_pop_to(w->a, position);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+internal Nothing
+io_scan_keep(IoScanWorker* w, Str8 path, U64 size, U64 mtime) {
+  if(!w->last || w->last->count == IO_SCAN_CHUNK) {
+    IoScanChunk* chunk = arena_push_array_no_zero(w->a, IoScanChunk, 1);
+    chunk->next = 0;
+    chunk->count = 0;
+    if(w->last) {
+      w->last->next = chunk;
+    } else {
+      w->first = chunk;
+    }
+    w->last = chunk;
+  }
+  w->last->entries[w->last->count++] = (IoEntry) {
+    .path = path, .size = size, .mtime = mtime
+  };
+  w->count += 1;
+}
+
+#if defined(OS_LINUX) || defined(OS_MAC)
+
+/* `type` is a DT_ value from the directory; files are only stat'ed once
+   they match, and symlinks are never followed */
+internal Nothing
+io_scan_entry(IoScanWorker* w, int fd, Str8 dir, CStr name, U8 type) {
+  struct stat st;
+  Bool stated = FALSE;
+  if(type == DT_UNKNOWN) {
+    stated = fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0;
+    type = !stated ? DT_UNKNOWN : S_ISDIR(st.st_mode) ? DT_DIR
+           : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+  }
+  if(type == DT_DIR) {
+    str8_list_push(w->a, &w->dirs, io_scan_join(w->a, dir, name));
+    return;
+  }
+  Str8 path;
+  U64 position = arena_get_position(w->a);
+  if(type != DT_REG || !io_scan_match(w, dir, name, &path)) {
+    return;
+  }
+  if(!stated && fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+    arena_pop_to(w->a, position);
+    return;
+  }
+#if defined(OS_MAC)
+  struct timespec mtime = st.st_mtimespec;
+#else
+  struct timespec mtime = st.st_mtim;
+#endif /* OS_MAC */
+  io_scan_keep(w, path, (U64)st.st_size,
+               (U64)mtime.tv_sec * Billion(1ull) + (U64)mtime.tv_nsec);
+}
+
+#endif /* OS_LINUX || OS_MAC */
+
+#if defined(OS_LINUX)
+
+internal Nothing
+io_scan_dir(IoScanWorker* w, Str8 dir) {
+  int fd = openat(AT_FDCWD, dir.cstr, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if(fd < 0) {
+    io_scan_fail(w, errno);
+    return;
+  }
+  w->directories += 1;
+  for(;;) {
+    long got = syscall(SYS_getdents64, fd, w->dents, IO_SCAN_DENTS);
+    if(got <= 0) {
+      if(got < 0) {
+        io_scan_fail(w, errno);
+      }
+      break;
+    }
+    for(long at = 0; at < got;) {
+      IoDirent* d = (IoDirent*)(w->dents + at);
+      at += d->reclen;
+      if(!io_scan_skip(w, d->name)) {
+        io_scan_entry(w, fd, dir, d->name, d->type);
+      }
+    }
+  }
+  close(fd);
+}
+
+#elif defined(OS_MAC)
+
+internal Nothing
+io_scan_dir(IoScanWorker* w, Str8 dir) {
+  DIR* d = opendir(dir.cstr);
+  if(!d) {
+    io_scan_fail(w, errno);
+    return;
+  }
+  w->directories += 1;
+  for(struct dirent* e = readdir(d); e; e = readdir(d)) {
+    if(!io_scan_skip(w, e->d_name)) {
+      io_scan_entry(w, dirfd(d), dir, e->d_name, e->d_type);
+    }
+  }
+  closedir(d);
+}
+
+#else /* OS_WINDOWS */
+
+/* the listing already carries size and write time, so nothing is opened */
+internal Nothing
+io_scan_dir(IoScanWorker* w, Str8 dir) {
+  U64 position = arena_get_position(w->a);
+  WIN32_FIND_DATAA found;
+  HANDLE find = FindFirstFileExA(io_scan_join(w->a, dir, "*").cstr, FindExInfoBasic, &found,
+                                 FindExSearchNameMatch, 0, FIND_FIRST_EX_LARGE_FETCH);
+  arena_pop_to(w->a, position);
+  if(find == INVALID_HANDLE_VALUE) {
+    io_scan_fail(w, (I32)GetLastError());
+    return;
+  }
+  w->directories += 1;
+  do {
+    CStr name = found.cFileName;
+    Str8 path;
+    if(io_scan_skip(w, name) || (found.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+      continue;
+    }
+    if(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      str8_list_push(w->a, &w->dirs, io_scan_join(w->a, dir, name));
+    } else if(io_scan_match(w, dir, name, &path)) {
+      U64 size = ((U64)found.nFileSizeHigh << 32) | found.nFileSizeLow;
+      U64 written = ((U64)found.ftLastWriteTime.dwHighDateTime << 32) |
+                    found.ftLastWriteTime.dwLowDateTime;
+      io_scan_keep(w, path, size, (written - 116444736000000000ull) * 100);
+    }
+  } while(FindNextFileA(find, &found));
+  FindClose(find);
+}
+
+#endif /* OS_LINUX */
+
+internal Nothing
+io_scan_worker(RawPtr arg) {
+  IoScanWorker* w = (IoScanWorker*)arg;
+  IoScanWalk* walk = w->walk;
+  for(U64 i = __atomic_fetch_add(&walk->next, 1, __ATOMIC_RELAXED); i < walk->dir_count;
+      i = __atomic_fetch_add(&walk->next, 1, __ATOMIC_RELAXED)) {
+    io_scan_dir(w, walk->dirs[i]);
+  }
+}
+
+internal Nothing
+io_scan_run(PlatformThread* threads, IoScanWorker* workers, U32 count) {
+  U32 started = 1;
+  for(; started < count; ++started) {
+    if(!platform_thread_start(&threads[started], io_scan_worker, &workers[started])) {
+      break;
+    }
+  }
+  io_scan_worker(&workers[0]);
+  for(U32 t = 1; t < started; ++t) {
+    platform_thread_join(&threads[t]);
+  }
+}
+
+/* every regular file under `root` whose path past the root matches
+   `glob` (see str8_glob; empty keeps everything), in no particular order.
+   the tree is walked a level at a time, `threads` workers (0 for one per
+   core) sharing each level's directories; entries and paths land in `a`
+   once the walk is done */
+MODULE IoScan
+io_scan(Arena* a, CStr root, Str8 glob, IoScanFlags flags, U32 threads) {
+  IoScan result = {0};
+  if(threads == 0) {
+    threads = platform_get_cpu_cores();
+  }
+  Str8 top = str8(root);
+  IoScanWalk walk = {
+    .glob = glob,
+    .flags = flags,
+    .rel = top.size + (top.size && top.cstr[top.size - 1] != '/'),
+  };
+  Arena* scratch = arena_alloc();
+  IoScanWorker* workers = arena_push_array_no_zero(scratch, IoScanWorker, threads);
+  PlatformThread* handles = arena_push_array(scratch, PlatformThread, threads);
+  for(U32 t = 0; t < threads; ++t) {
+    workers[t] = (IoScanWorker) {
+      .walk = &walk, .a = arena_alloc()
+    };
+    workers[t].dents = arena_push_array_no_zero(workers[t].a, U8, IO_SCAN_DENTS);
+  }
+
+  U64 levels = arena_get_position(scratch);
+  Str8* level = arena_push_array_no_zero(scratch, Str8, 1);
+  level[0] = top;
+  U64 level_count = 1;
+  while(level_count) {
+    walk.dirs = level;
+    walk.dir_count = level_count;
+    walk.next = 0;
+    io_scan_run(handles, workers, (U32)Min(threads, level_count));
+
+    level_count = 0;
+    for(U32 t = 0; t < threads; ++t) {
+      level_count += workers[t].dirs.node_count;
+    }
+    arena_pop_to(scratch, levels);
+    level = arena_push_array_no_zero(scratch, Str8, Max(1, level_count));
+    U64 at = 0;
+    for(U32 t = 0; t < threads; ++t) {
+      for(Str8Node* n = workers[t].dirs.first; n; n = n->next) {
+        level[at++] = n->string;
+      }
+      MemZeroStruct(&workers[t].dirs);
+    }
+  }
+
+  for(U32 t = 0; t < threads; ++t) {
+    result.count += workers[t].count;
+  }
+  result.entries = arena_push_array_no_zero(a, IoEntry, result.count);
+  U64 at = 0;
+  for(U32 t = 0; t < threads; ++t) {
+    for(IoScanChunk* chunk = workers[t].first; chunk; chunk = chunk->next) {
+      for(U64 i = 0; i < chunk->count; ++i) {
+        IoEntry* e = &result.entries[at++];
+        *e = chunk->entries[i];
+        e->path = str8_copy(a, e->path);
+      }
+    }
+    result.directories += workers[t].directories;
+    if(!result.error) {
+      result.error = workers[t].error;
+    }
+    arena_release(workers[t].a);
+  }
+  arena_release(scratch);
+
+  if((flags & IoScanFlag_Load) && result.count) {
+    CStr* paths = arena_push_array_no_zero(a, CStr, result.count);
+    for(U64 i = 0; i < result.count; ++i) {
+      paths[i] = result.entries[i].path.cstr;
+    }
+    IoLoad* loads = io_load_files(a, paths, result.count, 0, 0, 0);
+    for(U64 i = 0; i < result.count; ++i) {
+      result.entries[i].data = loads[i].data;
+      result.entries[i].error = loads[i].error;
+    }
+  }
+  return result;
 }
 
 /* ===================================================== */
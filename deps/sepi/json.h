@@ -0,0 +1,857 @@
+#ifndef SEPI_JSON_H
+#define SEPI_JSON_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "arena.h"
+#include "string.h"
+#include "hashmap.h"
+#include "unicode.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_JSON_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_JSON_IMPLEMENTATION */
+
+#define JSON_BLOCK 64
+#define JSON_MAX_DEPTH 1024
+#define JSON_MAX_SIZE 0xFFFFFFFFu
+/* structurals are found a chunk at a time so the index stays in cache */
+#define JSON_INDEX_CHUNK 4096
+#define JSON_LOOKAHEAD 8
+#define JSON_TAPE_CHUNK 4096
+/* objects with at least this many members get a hash index */
+#define JSON_INDEX_MIN 16
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+typedef U32 JsonKind;
+enum {
+  JsonKind_Null,
+  JsonKind_False,
+  JsonKind_True,
+  JsonKind_Number,
+  JsonKind_String,
+  JsonKind_Array,
+  JsonKind_Object,
+};
+
+typedef U32 JsonFlags;
+enum {
+  /* `text` still holds escapes, json_string decodes them */
+  JsonFlag_Escaped = (1 << 0),
+  /* the number fit an I64 and is in `integer` rather than `number` */
+  JsonFlag_Integer = (1 << 1),
+};
+
+typedef U32 JsonError;
+enum {
+  JsonError_None,
+  JsonError_Utf8,
+  JsonError_Syntax,
+  JsonError_String,
+  JsonError_Number,
+  JsonError_Depth,
+  JsonError_Trailing,
+  JsonError_Eof,
+  /* the source is JSON_MAX_SIZE or longer, offsets are kept in a U32 */
+  JsonError_Size,
+};
+
+/* values sit on a tape in document order, a container is followed by
+   everything inside it and `span` counts those entries plus itself, so
+   the next sibling of any value is `v + span`. an object member is its
+   key (a string) followed by its value. strings and numbers keep `text`
+   pointing into the source; keys are decoded while parsing, other
+   strings when json_string asks for them */
+typedef struct JsonValue JsonValue;
+struct JsonValue {
+  JsonKind kind;
+  JsonFlags flags;
+  U32 span;
+  /* array elements or object members */
+  U32 count;
+  Str8 text;
+  union {
+    F64 number;
+    I64 integer;
+    /* key to the offset of its value from the object */
+    HashMap* index;
+  };
+};
+
+/* everything, the document included, lives in the arena given to
+   json_parse; the source has to outlive it */
+typedef struct JsonDocument JsonDocument;
+struct JsonDocument {
+  Str8 source;
+  JsonValue* values;
+  U64 value_count;
+  JsonError error;
+  U64 error_offset;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE JsonDocument* json_parse(Arena* a, Str8 source);
+MODULE JsonValue* json_root(JsonDocument* doc);
+MODULE JsonValue* json_first(JsonValue* v);
+MODULE JsonValue* json_next(JsonValue* parent, JsonValue* child);
+MODULE JsonValue* json_at(JsonValue* array, U64 index);
+MODULE JsonValue* json_get(JsonValue* object, Str8 key);
+MODULE Str8 json_string(Arena* a, JsonValue* v);
+MODULE F64 json_f64(JsonValue* v);
+MODULE I64 json_i64(JsonValue* v);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_JSON_IMPLEMENTATION
+
+/* one bit per byte of a JSON_BLOCK byte block */
+typedef struct JsonMasks JsonMasks;
+struct JsonMasks {
+  U64 quote;
+  U64 backslash;
+  U64 op;
+  U64 space;
+  U64 control;
+};
+
+/* stage one's carries between blocks and the chunk of structurals it
+   hands to stage two, which writes the tape straight into the arena */
+typedef struct JsonParser JsonParser;
+struct JsonParser {
+  Arena* a;
+  JsonDocument* doc;
+  const U8* p;
+  U64 size;
+  U64 block;
+  U64 escape_carry;
+  U64 string_carry;
+  U64 scalar_carry;
+  Bool escapes;
+  U64 index_count;
+  U32 index[JSON_INDEX_CHUNK + 1];
+  JsonValue* tape;
+  U64 tape_count;
+  U64 tape_capacity;
+  Bool escaped_keys;
+  Bool large_objects;
+};
+
+/* the operators are {}[]:, and '[' ']' are '{' '}' with 0x20 cleared;
+   whitespace is the four bytes JSON allows, control is anything below
+   0x20, which strings may not hold raw */
+#if defined(__AVX2__)
+
+internal __m256i
+json_eq_32(__m256i v, U8 c) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8((I8)c));
+}
+
+internal Nothing
+json_classify(const U8* p, JsonMasks* m) {
+  MemZeroStruct(m);
+  for(U64 i = 0; i < JSON_BLOCK; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+    __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i op = _mm256_or_si256(_mm256_or_si256(json_eq_32(folded, '{'),
+                                                 json_eq_32(folded, '}')),
+                                 _mm256_or_si256(json_eq_32(v, ':'),
+                                                 json_eq_32(v, ',')));
+    __m256i space = _mm256_or_si256(_mm256_or_si256(json_eq_32(v, ' '),
+                                                    json_eq_32(v, '\t')),
+                                    _mm256_or_si256(json_eq_32(v, '\n'),
+                                                    json_eq_32(v, '\r')));
+    __m256i control = json_eq_32(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), 0x1F);
+    m->quote |= (U64)(U32)_mm256_movemask_epi8(json_eq_32(v, '"')) << i;
+    m->backslash |= (U64)(U32)_mm256_movemask_epi8(json_eq_32(v, '\\')) << i;
+    m->op |= (U64)(U32)_mm256_movemask_epi8(op) << i;
+    m->space |= (U64)(U32)_mm256_movemask_epi8(space) << i;
+    m->control |= (U64)(U32)_mm256_movemask_epi8(control) << i;
+  }
+}
+
+#elif defined(__SSE2__)
+
+internal __m128i
+json_eq_16(__m128i v, U8 c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8((I8)c));
+}
+
+internal Nothing
+json_classify(const U8* p, JsonMasks* m) {
+  MemZeroStruct(m);
+  for(U64 i = 0; i < JSON_BLOCK; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+    __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i op = _mm_or_si128(_mm_or_si128(json_eq_16(folded, '{'),
+                                           json_eq_16(folded, '}')),
+                              _mm_or_si128(json_eq_16(v, ':'), json_eq_16(v, ',')));
+    __m128i space = _mm_or_si128(_mm_or_si128(json_eq_16(v, ' '), json_eq_16(v, '\t')),
+                                 _mm_or_si128(json_eq_16(v, '\n'), json_eq_16(v, '\r')));
+    __m128i control = json_eq_16(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), 0x1F);
+    m->quote |= (U64)(U32)_mm_movemask_epi8(json_eq_16(v, '"')) << i;
+    m->backslash |= (U64)(U32)_mm_movemask_epi8(json_eq_16(v, '\\')) << i;
+    m->op |= (U64)(U32)_mm_movemask_epi8(op) << i;
+    m->space |= (U64)(U32)_mm_movemask_epi8(space) << i;
+    m->control |= (U64)(U32)_mm_movemask_epi8(control) << i;
+  }
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+/* no movemask on NEON: weight each lane by its bit and add pairwise */
+internal U64
+json_pack_neon(uint8x16_t* m) {
+  static const U8 weights[16] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+  };
+  uint8x16_t bit = vld1q_u8(weights);
+  uint8x16_t sum = vpaddq_u8(vpaddq_u8(vandq_u8(m[0], bit), vandq_u8(m[1], bit)),
+                             vpaddq_u8(vandq_u8(m[2], bit), vandq_u8(m[3], bit)));
+  sum = vpaddq_u8(sum, sum);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+
+internal Nothing
+json_classify(const U8* p, JsonMasks* m) {
+  uint8x16_t quote[4], backslash[4], op[4], space[4], control[4];
+  for(U64 i = 0; i < 4; ++i) {
+    uint8x16_t v = vld1q_u8(p + 16 * i);
+    uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(0x20));
+    quote[i] = vceqq_u8(v, vdupq_n_u8('"'));
+    backslash[i] = vceqq_u8(v, vdupq_n_u8('\\'));
+    op[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')),
+                              vceqq_u8(folded, vdupq_n_u8('}'))),
+                     vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+    space[i] = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+                        vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+    control[i] = vcltq_u8(v, vdupq_n_u8(0x20));
+  }
+  m->quote = json_pack_neon(quote);
+  m->backslash = json_pack_neon(backslash);
+  m->op = json_pack_neon(op);
+  m->space = json_pack_neon(space);
+  m->control = json_pack_neon(control);
+}
+
+#else
+
+internal Nothing
+json_classify(const U8* p, JsonMasks* m) {
+  MemZeroStruct(m);
+  for(U64 i = 0; i < JSON_BLOCK; ++i) {
+    U8 c = p[i];
+    U8 folded = c | 0x20;
+    m->quote |= (U64)(c == '"') << i;
+    m->backslash |= (U64)(c == '\\') << i;
+    m->op |= (U64)(folded == '{' || folded == '}' || c == ':' || c == ',') << i;
+    m->space |= (U64)(c == ' ' || c == '\t' || c == '\n' || c == '\r') << i;
+    m->control |= (U64)(c < 0x20) << i;
+  }
+}
+
+#endif /* __AVX2__ */
+
+/* bit i is the xor of bits 0..i, which turns quote bits into "inside a
+   string" bits: set from an opening quote up to the closing one */
+internal U64
+json_prefix_xor(U64 x) {
+#if defined(__AVX2__) && defined(__PCLMUL__)
+  __m128i all = _mm_set1_epi8((I8)0xFF);
+  return (U64)_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, (I64)x), all, 0));
+#else
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+#endif /* __AVX2__ && __PCLMUL__ */
+}
+
+internal Bool
+json_fail(JsonDocument* doc, JsonError error, U64 offset) {
+  doc->error = error;
+  doc->error_offset = offset;
+  return FALSE;
+}
+
+/* stage one: the offset of every operator outside strings, of both
+   quotes of every string and of the first byte of every other scalar,
+   appended until the chunk could not take another block. the source size
+   goes in as a sentinel once the source runs out. backslashes are rare
+   enough that walking them bit by bit beats carrying odd runs through
+   adds */
+internal Nothing
+json_structurals(JsonParser* j) {
+  while(j->block < j->size && j->index_count + JSON_BLOCK <= JSON_INDEX_CHUNK) {
+    U64 block = j->block;
+    U8 tail[JSON_BLOCK];
+    const U8* at = j->p + block;
+    if(j->size - block < JSON_BLOCK) {
+      memset(tail, ' ', sizeof(tail));
+      MemoryCopy(tail, at, j->size - block);
+      at = tail;
+    }
+    JsonMasks m;
+    json_classify(at, &m);
+
+    U64 escaped = j->escape_carry;
+    j->escape_carry = 0;
+    j->escapes |= m.backslash != 0;
+    for(U64 bits = m.backslash; bits; bits &= bits - 1) {
+      U64 i = (U64)__builtin_ctzll(bits);
+      if(!(escaped & ((U64)1 << i))) {
+        if(i == JSON_BLOCK - 1) {
+          j->escape_carry = 1;
+        } else {
+          escaped |= (U64)2 << i;
+        }
+      }
+    }
+
+    U64 quote = m.quote & ~escaped;
+    U64 in_string = json_prefix_xor(quote) ^ j->string_carry;
+    j->string_carry = (U64)((I64)in_string >> 63);
+    U64 scalar = ~(m.op | m.space | quote | in_string);
+    U64 scalar_start = scalar & ~((scalar << 1) | j->scalar_carry);
+    j->scalar_carry = scalar >> 63;
+
+    U64 control = m.control & in_string;
+    if(control) {
+      json_fail(j->doc, JsonError_String, block + (U64)__builtin_ctzll(control));
+      return;
+    }
+
+    U64 structural = (m.op & ~in_string) | quote | scalar_start;
+    U32* out = j->index + j->index_count;
+    j->index_count += (U64)__builtin_popcountll(structural);
+    while(structural) {
+      *out++ = (U32)(block + (U64)__builtin_ctzll(structural));
+      structural &= structural - 1;
+    }
+    j->block += JSON_BLOCK;
+  }
+  if(j->block >= j->size) {
+    if(j->string_carry) {
+      json_fail(j->doc, JsonError_Eof, j->size);
+    }
+    j->index[j->index_count] = (U32)j->size;
+  }
+}
+
+internal U64
+json_digits(Str8 s, U64 i) {
+  while(i < s.size && (U8)(s.cstr[i] - '0') < 10) {
+    i += 1;
+  }
+  return i;
+}
+
+/* size of the JSON number at the start of `s`, 0 when there is none.
+   plain integers short enough not to overflow come back in `integer`,
+   everything else is left for str8_to_i64 and str8_to_f64 */
+internal U64
+json_number_size(Str8 s, Bool* small_integer, I64* integer) {
+  const U8* p = (const U8*)s.cstr;
+  Bool negative = s.size && p[0] == '-';
+  U64 i = negative;
+  U64 start = i;
+  if(i < s.size && p[i] == '0') {
+    i += 1;
+  } else if(i < s.size && '1' <= p[i] && p[i] <= '9') {
+    i = json_digits(s, i);
+  } else {
+    return 0;
+  }
+  U64 whole = i;
+  if(i < s.size && p[i] == '.') {
+    U64 digits = i + 1;
+    i = json_digits(s, digits);
+    if(i == digits) {
+      return 0;
+    }
+  }
+  if(i < s.size && (p[i] | 0x20) == 'e') {
+    i += 1;
+    if(i < s.size && (p[i] == '+' || p[i] == '-')) {
+      i += 1;
+    }
+    U64 digits = i;
+    i = json_digits(s, digits);
+    if(i == digits) {
+      return 0;
+    }
+  }
+  *small_integer = i == whole && whole - start <= 18;
+  if(*small_integer) {
+    U64 value = 0;
+    for(U64 k = start; k < whole; ++k) {
+      value = value * 10 + (U64)(p[k] - '0');
+    }
+    *integer = negative ? -(I64)value : (I64)value;
+  }
+  return i;
+}
+
+internal Bool
+json_is_space(U8 c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* a scalar runs up to the next structural, less the whitespace before it */
+internal Bool
+json_scalar(JsonParser* j, JsonValue* v, U64 at, U64 end) {
+  const U8* p = j->p;
+  while(end > at && json_is_space(p[end - 1])) {
+    end -= 1;
+  }
+  Str8 text = str8_raw((U8*)p + at, end - at);
+  v->flags = 0;
+  v->span = 1;
+  v->count = 0;
+  v->text = text;
+  v->integer = 0;
+  U8 c = p[at];
+  if(c == 'n' || c == 't' || c == 'f') {
+    v->kind = c == 'n' ? JsonKind_Null : c == 't' ? JsonKind_True : JsonKind_False;
+    CStr literal = c == 'n' ? "null" : c == 't' ? "true" : "false";
+    if(text.size != 4 + (c == 'f') || !IsMemoryEq(text.cstr, literal, text.size)) {
+      return json_fail(j->doc, JsonError_Syntax, at);
+    }
+    return TRUE;
+  }
+  Bool small_integer = FALSE;
+  if(json_number_size(text, &small_integer, &v->integer) != text.size) {
+    return json_fail(j->doc, is_alpha_char(c) ? JsonError_Syntax : JsonError_Number, at);
+  }
+  v->kind = JsonKind_Number;
+  Bool integral = text.size == json_digits(text, c == '-');
+  if(small_integer || (integral && !str8_to_i64(text, 10, &v->integer).overflow)) {
+    v->flags = JsonFlag_Integer;
+  } else {
+    str8_to_f64(text, &v->number);
+  }
+  return TRUE;
+}
+
+internal U32
+json_hex4(const U8* p) {
+  U32 result = 0;
+  for(U64 i = 0; i < 4; ++i) {
+    U8 c = p[i];
+    U32 digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+    result = (result << 4) | digit;
+  }
+  return result;
+}
+
+/* checks the escapes of a string, whose other bytes stage one already
+   vetted */
+internal Bool
+json_string_escapes_valid(Str8 s) {
+  const U8* p = (const U8*)s.cstr;
+  for(U64 i = 0; i < s.size; ++i) {
+    if(p[i] != '\\') {
+      continue;
+    }
+    if(i + 1 >= s.size) {
+      return FALSE;
+    }
+    U8 c = p[++i];
+    if(c == 'u') {
+      if(i + 4 >= s.size) {
+        return FALSE;
+      }
+      for(U64 k = 1; k <= 4; ++k) {
+        if(!is_digit_char(p[i + k], 16)) {
+          return FALSE;
+        }
+      }
+      i += 4;
+    } else if(c != '"' && c != '\\' && c != '/' && c != 'b' && c != 'f' &&
+              c != 'n' && c != 'r' && c != 't') {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/* decoded text never outgrows the escaped one: \uXXXX is six bytes for
+   at most three, a surrogate pair twelve for four. lone surrogates
+   become U+FFFD */
+internal Str8
+json_unescape(Arena* a, Str8 s) {
+  const U8* p = (const U8*)s.cstr;
+  U8* out = arena_push_array_no_zero(a, U8, s.size + 1);
+  U64 n = 0;
+  U64 i = 0;
+  while(i < s.size) {
+    const U8* backslash = memchr(p + i, '\\', s.size - i);
+    U64 run = backslash ? (U64)(backslash - (p + i)) : s.size - i;
+    MemoryCopy(out + n, p + i, run);
+    n += run;
+    i += run;
+    if(i >= s.size) {
+      break;
+    }
+    U8 c = p[i + 1];
+    i += 2;
+    if(c == 'u') {
+      U32 codepoint = json_hex4(p + i);
+      i += 4;
+      if(0xD800 <= codepoint && codepoint < 0xDC00 && i + 6 <= s.size &&
+         p[i] == '\\' && p[i + 1] == 'u') {
+        U32 low = json_hex4(p + i + 2);
+        if(0xDC00 <= low && low < 0xE000) {
+          codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+          i += 6;
+        }
+      }
+      if(0xD800 <= codepoint && codepoint < 0xE000) {
+        codepoint = UNICODE_REPLACEMENT;
+      }
+      n += utf8_encode(out + n, codepoint);
+    } else {
+      out[n++] = c == 'b' ? '\b' : c == 'f' ? '\f' : c == 'n' ? '\n' :
+                 c == 'r' ? '\r' : c == 't' ? '\t' : c;
+    }
+  }
+  out[n] = 0;
+  arena_pop(a, s.size - n);
+  return str8_raw(out, n);
+}
+
+/* `at` is the opening quote, `close` the closing one */
+internal Bool
+json_string_value(JsonParser* j, JsonValue* v, U64 at, U64 close) {
+  Str8 text = str8_raw((U8*)j->p + at + 1, close - at - 1);
+  v->kind = JsonKind_String;
+  v->flags = 0;
+  v->span = 1;
+  v->count = 0;
+  v->text = text;
+  v->integer = 0;
+  if(j->escapes && memchr(text.cstr, '\\', text.size)) {
+    if(!json_string_escapes_valid(text)) {
+      return json_fail(j->doc, JsonError_String, at);
+    }
+    v->flags = JsonFlag_Escaped;
+  }
+  return TRUE;
+}
+
+/* room for JSON_TAPE_CHUNK more values; the tape is the only thing
+   pushed while parsing, so it grows in place unless the arena moves on to
+   a new block, then it moves along at twice the size so the copies left
+   behind stay linear. there is at most one value per source byte plus one */
+internal Nothing
+json_tape_grow(JsonParser* j) {
+  U64 position = arena_get_position(j->a);
+  JsonValue* more = arena_push_array_no_zero(j->a, JsonValue, JSON_TAPE_CHUNK);
+  if(more == j->tape + j->tape_capacity) {
+    j->tape_capacity += JSON_TAPE_CHUNK;
+    return;
+  }
+  arena_pop_to(j->a, position);
+  U64 capacity = Max(j->tape_count + JSON_TAPE_CHUNK,
+                     Min(j->tape_capacity * 2, j->size + 1));
+  more = arena_push_array_no_zero(j->a, JsonValue, capacity);
+  if(j->tape_count) {
+    MemoryCopy(more, j->tape, j->tape_count * sizeof(JsonValue));
+  }
+  j->tape = more;
+  j->tape_capacity = capacity;
+}
+
+internal U8
+json_peek(JsonParser* j, U64 k) {
+  U64 at = j->index[k];
+  return at < j->size ? j->p[at] : 0;
+}
+
+/* stage two: one pass over the structurals with an explicit stack of
+   open containers. an iteration takes a separator, key and colon along
+   with the value they lead to, so it may look JSON_LOOKAHEAD structurals
+   ahead and the chunk is refilled before it gets that short */
+internal Bool
+json_tape(JsonParser* j) {
+  JsonDocument* doc = j->doc;
+  U32 stack[JSON_MAX_DEPTH];
+  U64 depth = 0;
+  Bool after = FALSE;
+  Bool key = FALSE;
+  U64 k = 0;
+
+  json_structurals(j);
+  while(!doc->error) {
+    if(k + JSON_LOOKAHEAD > j->index_count && j->block < j->size) {
+      U64 left = j->index_count - k;
+      memmove(j->index, j->index + k, left * sizeof(U32));
+      j->index_count = left;
+      k = 0;
+      json_structurals(j);
+      continue;
+    }
+    if(j->tape_count + 2 > j->tape_capacity) {
+      json_tape_grow(j);
+    }
+    JsonValue* tape = j->tape;
+    JsonValue* parent = depth ? tape + stack[depth - 1] : 0;
+
+    if(after) {
+      if(!parent) {
+        if(k < j->index_count) {
+          return json_fail(doc, JsonError_Trailing, j->index[k]);
+        }
+        break;
+      }
+      U8 c = json_peek(j, k);
+      if(c == ',') {
+        k += 1;
+        key = parent->kind == JsonKind_Object;
+      } else if(c == (parent->kind == JsonKind_Object ? '}' : ']')) {
+        k += 1;
+        depth -= 1;
+        parent->span = (U32)(j->tape_count - stack[depth]);
+        j->large_objects |= parent->kind == JsonKind_Object &&
+                            parent->count >= JSON_INDEX_MIN;
+        continue;
+      } else {
+        return json_fail(doc, c ? JsonError_Syntax : JsonError_Eof, j->index[k]);
+      }
+    }
+
+    if(key) {
+      JsonValue* name = tape + j->tape_count;
+      if(json_peek(j, k) != '"') {
+        return json_fail(doc, JsonError_Syntax, j->index[k]);
+      }
+      if(!json_string_value(j, name, j->index[k], j->index[k + 1])) {
+        return FALSE;
+      }
+      if(json_peek(j, k + 2) != ':') {
+        return json_fail(doc, JsonError_Syntax, j->index[k + 2]);
+      }
+      j->escaped_keys |= (name->flags & JsonFlag_Escaped) != 0;
+      j->tape_count += 1;
+      parent->count += 1;
+      k += 3;
+    } else if(parent) {
+      parent->count += 1;
+    }
+
+    U64 at = j->index[k];
+    U8 c = json_peek(j, k);
+    JsonValue* v = tape + j->tape_count;
+    k += 1;
+    after = TRUE;
+    if(c == '{' || c == '[') {
+      if(depth == JSON_MAX_DEPTH) {
+        return json_fail(doc, JsonError_Depth, at);
+      }
+      v->kind = c == '{' ? JsonKind_Object : JsonKind_Array;
+      v->flags = 0;
+      v->span = 1;
+      v->count = 0;
+      v->text = str8_raw((U8*)j->p + at, 1);
+      v->index = 0;
+      /* '{' + 2 is '}' and '[' + 2 is ']' */
+      if(json_peek(j, k) == c + 2) {
+        k += 1;
+      } else {
+        stack[depth++] = (U32)j->tape_count;
+        key = c == '{';
+        after = FALSE;
+      }
+    } else if(c == '"') {
+      if(!json_string_value(j, v, at, j->index[k++])) {
+        return FALSE;
+      }
+    } else if(c == 0 || c == ',' || c == ':' || (c | 0x20) == '}') {
+      return json_fail(doc, c ? JsonError_Syntax : JsonError_Eof, at);
+    } else if(!json_scalar(j, v, at, j->index[k])) {
+      return FALSE;
+    }
+    j->tape_count += 1;
+  }
+  return doc->error == JsonError_None;
+}
+
+/* keys are decoded and large objects indexed once the tape stopped
+   moving; the first member wins when a key repeats, as with the linear
+   scan */
+internal Nothing
+json_finish(JsonParser* j) {
+  JsonDocument* doc = j->doc;
+  for(U64 i = 0; i < doc->value_count && (j->escaped_keys || j->large_objects); ++i) {
+    JsonValue* v = doc->values + i;
+    if(v->kind != JsonKind_Object) {
+      continue;
+    }
+    for(JsonValue* key = json_first(v); key && j->escaped_keys; key = json_next(v, key)) {
+      if(key->flags & JsonFlag_Escaped) {
+        key->text = json_unescape(j->a, key->text);
+        key->flags = 0;
+      }
+    }
+    if(v->count < JSON_INDEX_MIN) {
+      continue;
+    }
+    HashMap* hm = hashmap_init(j->a, v->count);
+    for(JsonValue* key = json_first(v); key; key = json_next(v, key)) {
+      Bool inserted;
+      HashMapKV* kv = hashmap_get_or_insert(j->a, hm, key->text, &inserted);
+      if(inserted) {
+        kv->v_u64 = (U64)(key + 1 - v);
+      }
+    }
+    v->index = hm;
+  }
+}
+
+/* validates UTF-8 up front, then runs both stages interleaved; a failed
+   parse gives back everything but the document */
+MODULE JsonDocument*
+json_parse(Arena* a, Str8 source) {
+  JsonDocument* doc = arena_push_array(a, JsonDocument, 1);
+  doc->source = source;
+  if(source.size >= JSON_MAX_SIZE) {
+    json_fail(doc, JsonError_Size, JSON_MAX_SIZE);
+    return doc;
+  }
+  if(!utf8_validate(source)) {
+    json_fail(doc, JsonError_Utf8, utf8_valid_size(source));
+    return doc;
+  }
+
+  U64 position = arena_get_position(a);
+  JsonParser parser;
+  MemZeroStruct(&parser);
+  parser.a = a;
+  parser.doc = doc;
+  parser.p = (const U8*)source.cstr;
+  parser.size = source.size;
+  if(!json_tape(&parser)) {
+    arena_pop_to(a, position);
+    return doc;
+  }
+  arena_pop(a, (parser.tape_capacity - parser.tape_count) * sizeof(JsonValue));
+  doc->values = parser.tape;
+  doc->value_count = parser.tape_count;
+  json_finish(&parser);
+  return doc;
+}
+
+/* 0 when parsing failed */
+MODULE JsonValue*
+json_root(JsonDocument* doc) {
+  return doc->error == JsonError_None ? doc->values : 0;
+}
+
+/* the first element, or the first member's key; 0 when empty */
+MODULE JsonValue*
+json_first(JsonValue* v) {
+  Bool container = v->kind == JsonKind_Array || v->kind == JsonKind_Object;
+  return container && v->span > 1 ? v + 1 : 0;
+}
+
+/* the element after `child`, or for objects the key after the member
+   keyed by `child` */
+MODULE JsonValue*
+json_next(JsonValue* parent, JsonValue* child) {
+  if(parent->kind == JsonKind_Object) {
+    child += 1;
+  }
+  JsonValue* next = child + child->span;
+  return next < parent + parent->span ? next : 0;
+}
+
+/* walks the elements, arrays are not indexed */
+MODULE JsonValue*
+json_at(JsonValue* array, U64 index) {
+  if(array->kind != JsonKind_Array || index >= array->count) {
+    return 0;
+  }
+  JsonValue* v = json_first(array);
+  for(U64 i = 0; i < index; ++i) {
+    v += v->span;
+  }
+  return v;
+}
+
+MODULE JsonValue*
+json_get(JsonValue* object, Str8 key) {
+  if(object->kind != JsonKind_Object) {
+    return 0;
+  }
+  if(object->index) {
+    HashMapKV* kv = hashmap_find(object->index, key);
+    return kv ? object + kv->v_u64 : 0;
+  }
+  for(JsonValue* k = json_first(object); k; k = json_next(object, k)) {
+    if(str8_cmp(k->text, key, 0)) {
+      return k + 1;
+    }
+  }
+  return 0;
+}
+
+/* the source slice itself unless the string has escapes, then a decoded
+   copy in `a` */
+MODULE Str8
+json_string(Arena* a, JsonValue* v) {
+  if(v->kind != JsonKind_String) {
+    return str8_zero();
+  }
+  return v->flags & JsonFlag_Escaped ? json_unescape(a, v->text) : v->text;
+}
+
+MODULE F64
+json_f64(JsonValue* v) {
+  if(v->kind != JsonKind_Number) {
+    return 0;
+  }
+  return v->flags & JsonFlag_Integer ? (F64)v->integer : v->number;
+}
+
+MODULE I64
+json_i64(JsonValue* v) {
+  if(v->kind != JsonKind_Number) {
+    return 0;
+  }
+  return v->flags & JsonFlag_Integer ? v->integer : (I64)v->number;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_JSON_IMPLEMENTATION */
+#endif /* SEPI_JSON_H */
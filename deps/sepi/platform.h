@@ -7,6 +7,12 @@
 
 #include "base.h"
 
+#if defined(OS_LINUX) || defined(OS_MAC)
+#include <pthread.h>
+#else /* OS_WINDOWS */
+#include <synchapi.h>
+#endif
+
 /* ===================================================== */
 /*                       CONSTANTS                       */
 /* ===================================================== */
@@ -17,6 +23,30 @@
 #define MODULE static
 #endif /* SEPI_PLATFORM_IMPLEMENTATION */
 
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+#if defined(OS_LINUX) || defined(OS_MAC)
+typedef pthread_mutex_t PlatformMutexHandle;
+#else /* OS_WINDOWS */
+typedef SRWLOCK PlatformMutexHandle;
+#endif
+
+typedef Nothing (*PlatformThreadFn)(RawPtr arg);
+
+typedef struct PlatformMutex PlatformMutex;
+struct PlatformMutex {
+  PlatformMutexHandle handle;
+};
+
+typedef struct PlatformThread PlatformThread;
+struct PlatformThread {
+  U64 handle;
+  PlatformThreadFn fn;
+  RawPtr arg;
+};
+
 /* ===================================================== */
 /*                          API                          */
 /* ===================================================== */
@@ -27,6 +57,14 @@ MODULE Sz platform_get_large_page_size();
 MODULE RawPtr platform_reserve_large_pages(Sz size);
 MODULE U32 platform_commit_large_pages(RawPtr ptr, Sz size);
 MODULE Nothing platform_release(RawPtr ptr, Sz size);
+MODULE Bool platform_thread_start(PlatformThread* t, PlatformThreadFn fn,
+                                  RawPtr arg);
+MODULE Nothing platform_thread_join(PlatformThread* t);
+MODULE Nothing platform_mutex_init(PlatformMutex* m);
+MODULE Nothing platform_mutex_destroy(PlatformMutex* m);
+MODULE Nothing platform_mutex_lock(PlatformMutex* m);
+MODULE Nothing platform_mutex_unlock(PlatformMutex* m);
+MODULE Bool platform_get_entropy(RawPtr buffer, Sz size);
 
 /* ===================================================== */
 /*                    IMPLEMENTATION                     */
@@ -39,6 +77,7 @@ MODULE Nothing platform_release(RawPtr ptr, Sz size);
 #include <sys/sysinfo.h> /* get_nprocs */
 #include <unistd.h> /* getpagesize */
 #include <sys/mman.h> /* mmap */
+#include <sys/random.h> /* getentropy */
 
 MODULE U32
 platform_get_cpu_cores() {
@@ -80,10 +119,67 @@ platform_release(RawPtr ptr, Sz size) {
   munmap(ptr, size);
 }
 
+internal RawPtr
+platform_thread_entry(RawPtr arg) {
+  PlatformThread* t = (PlatformThread*)arg;
+  t->fn(t->arg);
+  return 0;
+}
+
+MODULE Bool
+platform_thread_start(PlatformThread* t, PlatformThreadFn fn, RawPtr arg) {
+  pthread_t handle;
+  t->fn = fn;
+  t->arg = arg;
+  if(pthread_create(&handle, 0, platform_thread_entry, t) != 0) {
+    return FALSE;
+  }
+  t->handle = (U64)handle;
+  return TRUE;
+}
+
+MODULE Nothing
+platform_thread_join(PlatformThread* t) {
+  pthread_join((pthread_t)t->handle, 0);
+}
+
+MODULE Nothing
+platform_mutex_init(PlatformMutex* m) {
+  pthread_mutex_init(&m->handle, 0);
+}
+
+MODULE Nothing
+platform_mutex_destroy(PlatformMutex* m) {
+  pthread_mutex_destroy(&m->handle);
+}
+
+MODULE Nothing
+platform_mutex_lock(PlatformMutex* m) {
+  pthread_mutex_lock(&m->handle);
+}
+
+MODULE Nothing
+platform_mutex_unlock(PlatformMutex* m) {
+  pthread_mutex_unlock(&m->handle);
+}
+
+/* getentropy caps a single call at 256 bytes */
+MODULE Bool
+platform_get_entropy(RawPtr buffer, Sz size) {
+  for(Sz at = 0; at < size; at += 256) {
+    if(getentropy((U8*)buffer + at, Min(size - at, 256)) != 0) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
 #else /* OS_WINDOWS */
 
 #include <sysinfoapi.h>
 #include <memoryapi.h>
+#include <processthreadsapi.h>
+#include <bcrypt.h> /* link with bcrypt.lib */
 
 MODULE U32
 platform_get_cpu_cores() {
@@ -122,6 +218,57 @@ platform_release(RawPtr ptr, Sz size) {
   VirtualFree(ptr, 0, MEM_RELEASE);
 }
 
+internal DWORD WINAPI
+platform_thread_entry(LPVOID arg) {
+  PlatformThread* t = (PlatformThread*)arg;
+  t->fn(t->arg);
+  return 0;
+}
+
+MODULE Bool
+platform_thread_start(PlatformThread* t, PlatformThreadFn fn, RawPtr arg) {
+  t->fn = fn;
+  t->arg = arg;
+  HANDLE handle = CreateThread(0, 0, platform_thread_entry, t, 0, 0);
+  if(handle == 0) {
+    return FALSE;
+  }
+  t->handle = (U64)handle;
+  return TRUE;
+}
+
+MODULE Nothing
+platform_thread_join(PlatformThread* t) {
+  WaitForSingleObject((HANDLE)t->handle, INFINITE);
+  CloseHandle((HANDLE)t->handle);
+}
+
+MODULE Nothing
+platform_mutex_init(PlatformMutex* m) {
+  InitializeSRWLock(&m->handle);
+}
+
+MODULE Nothing
+platform_mutex_destroy(PlatformMutex* m) {
+  Ignore(m);
+}
+
+MODULE Nothing
+platform_mutex_lock(PlatformMutex* m) {
+  AcquireSRWLockExclusive(&m->handle);
+}
+
+MODULE Nothing
+platform_mutex_unlock(PlatformMutex* m) {
+  ReleaseSRWLockExclusive(&m->handle);
+}
+
+MODULE Bool
+platform_get_entropy(RawPtr buffer, Sz size) {
+  return BCRYPT_SUCCESS(BCryptGenRandom(0, (PUCHAR)buffer, (ULONG)size,
+                                        BCRYPT_USE_SYSTEM_PREFERRED_RNG));
+}
+
 #endif
 
 /* ===================================================== */
@@ -0,0 +1,106 @@
+#ifndef SEPI_POOL_H
+#define SEPI_POOL_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "arena.h"
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_POOL_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_POOL_IMPLEMENTATION */
+
+#define POOL_DEFAULT_BATCH 64
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+typedef struct PoolSlot PoolSlot;
+struct PoolSlot {
+  PoolSlot* next;
+};
+
+typedef struct Pool Pool;
+struct Pool {
+  Arena* arena;
+  PoolSlot* free;
+  U64 slot_size;
+  U64 slot_align;
+  U64 batch;
+  U64 used;
+  U64 allocated;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE Pool* pool_init(Arena* a, U64 slot_size, U64 slot_align);
+MODULE RawPtr pool_push(Pool* p, Bool with_zero);
+MODULE Nothing pool_pop(Pool* p, RawPtr slot);
+
+#define pool_init_typed(arena, type) pool_init((arena), sizeof(type), Max(8, AlignOf(type)))
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_POOL_IMPLEMENTATION
+
+MODULE Pool*
+pool_init(Arena* a, U64 slot_size, U64 slot_align) {
+  Pool* p = arena_push_array(a, Pool, 1);
+  p->arena = a;
+  p->slot_align = Max(slot_align, AlignOf(PoolSlot));
+  p->slot_size = AlignUp(Max(slot_size, sizeof(PoolSlot)), p->slot_align);
+  p->batch = POOL_DEFAULT_BATCH;
+  return p;
+}
+
+MODULE RawPtr
+pool_push(Pool* p, Bool with_zero) {
+  if(p->free == 0) {
+    U8* batch = (U8*)arena_push(p->arena, p->slot_size * p->batch,
+                                p->slot_align, FALSE);
+    for(U64 i = p->batch; i > 0; --i) {
+      PoolSlot* slot = (PoolSlot*)(batch + (i - 1) * p->slot_size);
+      slot->next = p->free;
+      p->free = slot;
+    }
+    p->allocated += p->batch;
+  }
+
+  PoolSlot* slot = p->free;
+  p->free = slot->next;
+  p->used += 1;
+
+  if(with_zero) {
+    MemZero(slot, p->slot_size);
+  }
+  return slot;
+}
+
+MODULE Nothing
+pool_pop(Pool* p, RawPtr ptr) {
+  PoolSlot* slot = (PoolSlot*)ptr;
+  Assert(p->used > 0);
+  slot->next = p->free;
+  p->free = slot;
+  p->used -= 1;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_POOL_IMPLEMENTATION */
+#endif /* SEPI_POOL_H */
@@ -0,0 +1,294 @@
+#ifndef SEPI_SEARCH_H
+#define SEPI_SEARCH_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "arena.h"
+#include "string.h"
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_SEARCH_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_SEARCH_IMPLEMENTATION */
+
+#define SEARCH_OUTPUT_FLAG 0x80000000u
+#define SEARCH_ROW_MASK 0x7FFFFFFFu
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+/* `offset` is where the match starts in the haystack */
+typedef struct SearchMatch SearchMatch;
+struct SearchMatch {
+  U32 pattern;
+  U64 offset;
+};
+
+/* Aho-Corasick compiled to a dense DFA over byte classes. bytes that no
+   pattern uses share class 0, folded spellings share a class. `next` is
+   indexed by row + class, where a row is state * class_count (up to 257
+   when patterns use every byte value), and holds
+   the next row with SEARCH_OUTPUT_FLAG set when that state ends patterns;
+   those are `outputs[output_first[state] .. output_first[state + 1])`.
+   `starts` are the bytes that leave the root; when there are few enough
+   for the vector byte search, `skip` lets the scan jump over the rest */
+typedef struct SearchAutomaton SearchAutomaton;
+struct SearchAutomaton {
+  U32* next;
+  U32* output_first;
+  U32* outputs;
+  U32* pattern_sizes;
+  U32 state_count;
+  U32 class_count;
+  U32 pattern_count;
+  StringCompareFlags flags;
+  Bool skip;
+  U16 classes[256];
+  Str8ByteSet starts;
+};
+
+/* `output` walks the pattern list of the state reached at `at` - 1 */
+typedef struct SearchIter SearchIter;
+struct SearchIter {
+  SearchAutomaton* ac;
+  Str8 haystack;
+  U64 at;
+  U32 row;
+  U32 output;
+  U32 output_end;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE SearchAutomaton* search_build(Arena* a, Str8* patterns, U64 count,
+                                     StringCompareFlags flags);
+MODULE SearchIter search_iter(SearchAutomaton* ac, Str8 haystack);
+MODULE Bool search_next(SearchIter* it, SearchMatch* match);
+MODULE U64 search_count(SearchAutomaton* ac, Str8 haystack);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_SEARCH_IMPLEMENTATION
+
+internal U8
+search_fold(U8 c, StringCompareFlags flags) {
+  if(flags & StringCompareFlag_CaseInsensitive) {
+    c = to_upper_char(c);
+  }
+  if(flags & StringCompareFlag_SlashInsensitive) {
+    c = correct_slash_from_char(c);
+  }
+  return c;
+}
+
+/* the trie is built in place in the transition table (0 meaning "no
+   child", the root is never anyone's child), then a breadth-first pass
+   fills every missing edge from the failure state's row, which is final
+   by then because it is shallower. build tables live in a throwaway
+   arena, only the automaton lands in `a`. empty patterns never match */
+MODULE SearchAutomaton*
+search_build(Arena* a, Str8* patterns, U64 count, StringCompareFlags flags) {
+  SearchAutomaton* ac = arena_push_array(a, SearchAutomaton, 1);
+  ac->flags = flags;
+  ac->pattern_count = (U32)count;
+  ac->pattern_sizes = arena_push_array_no_zero(a, U32, count + 1);
+
+  U16 canonical[256];
+  MemZeroArray(canonical);
+  U64 total = 0;
+  for(U64 p = 0; p < count; ++p) {
+    ac->pattern_sizes[p] = (U32)patterns[p].size;
+    total += patterns[p].size;
+    for(U64 i = 0; i < patterns[p].size; ++i) {
+      U8 c = search_fold((U8)patterns[p].cstr[i], flags);
+      if(!canonical[c]) {
+        canonical[c] = (U16)(++ac->class_count);
+      }
+    }
+  }
+  ac->class_count += 1;
+  for(U32 b = 0; b < 256; ++b) {
+    ac->classes[b] = canonical[search_fold((U8)b, flags)];
+  }
+
+  Arena* scratch = arena_alloc();
+  U64 classes = ac->class_count;
+  U64 capacity = total + 1;
+  AssertAlways(capacity * classes <= SEARCH_ROW_MASK);
+  U32* table = arena_push_array(scratch, U32, capacity * classes);
+  U32* terminal = arena_push_array(scratch, U32, capacity);
+  U32* pattern_next = arena_push_array(scratch, U32, count + 1);
+  U32 states = 1;
+  for(U64 p = 0; p < count; ++p) {
+    if(patterns[p].size == 0) {
+      continue;
+    }
+    U32 state = 0;
+    for(U64 i = 0; i < patterns[p].size; ++i) {
+      U32* edge = &table[state * classes + ac->classes[(U8)patterns[p].cstr[i]]];
+      if(*edge == 0) {
+        *edge = states++;
+      }
+      state = *edge;
+    }
+    pattern_next[p + 1] = terminal[state];
+    terminal[state] = (U32)p + 1;
+  }
+
+  U32* fail = arena_push_array(scratch, U32, states);
+  U32* order = arena_push_array_no_zero(scratch, U32, states);
+  U32* own = arena_push_array(scratch, U32, states);
+  U64 head = 0;
+  U64 tail = 0;
+  order[tail++] = 0;
+  while(head < tail) {
+    U32 state = order[head++];
+    for(U64 c = 0; c < classes; ++c) {
+      U32* edge = &table[state * classes + c];
+      U32 via_fail = state ? table[fail[state] * classes + c] : 0;
+      if(*edge) {
+        fail[*edge] = via_fail;
+        order[tail++] = *edge;
+      } else {
+        *edge = via_fail;
+      }
+    }
+    for(U32 p = terminal[state]; p; p = pattern_next[p]) {
+      own[state] += 1;
+    }
+  }
+
+  /* a state reports its own patterns, then everything its failure state
+     reports, which is again complete by breadth-first order */
+  ac->state_count = states;
+  ac->output_first = arena_push_array_no_zero(a, U32, states + 1);
+  U32* output_count = arena_push_array(scratch, U32, states);
+  U64 output_total = 0;
+  for(U64 k = 1; k < states; ++k) {
+    U32 state = order[k];
+    output_count[state] = own[state] + output_count[fail[state]];
+  }
+  for(U64 state = 0; state < states; ++state) {
+    ac->output_first[state] = (U32)output_total;
+    output_total += output_count[state];
+  }
+  ac->output_first[states] = (U32)output_total;
+  ac->outputs = arena_push_array_no_zero(a, U32, output_total + 1);
+  for(U64 k = 1; k < states; ++k) {
+    U32 state = order[k];
+    U32* out = ac->outputs + ac->output_first[state];
+    for(U32 p = terminal[state]; p; p = pattern_next[p]) {
+      *out++ = p - 1;
+    }
+    MemoryCopy(out, ac->outputs + ac->output_first[fail[state]],
+               output_count[fail[state]] * sizeof(U32));
+  }
+
+  ac->next = arena_push_array_no_zero(a, U32, states * classes);
+  for(U64 i = 0; i < states * classes; ++i) {
+    U32 state = table[i];
+    U32 flag = output_count[state] ? SEARCH_OUTPUT_FLAG : 0;
+    ac->next[i] = (U32)(state * classes) | flag;
+  }
+
+  U8 starts[256];
+  U64 start_count = 0;
+  for(U32 b = 0; b < 256; ++b) {
+    if(table[ac->classes[b]] != 0) {
+      starts[start_count++] = (U8)b;
+    }
+  }
+  ac->starts = str8_byte_set(str8_raw(starts, start_count), 0);
+  ac->skip = ac->starts.count <= STR8_FIND_ANY_VECTOR_MAX;
+
+  arena_release(scratch);
+  return ac;
+}
+
+MODULE SearchIter
+search_iter(SearchAutomaton* ac, Str8 haystack) {
+  SearchIter it = {0};
+  it.ac = ac;
+  it.haystack = haystack;
+  return it;
+}
+
+/* every occurrence of every pattern, overlapping ones included, in order
+   of where they end */
+MODULE Bool
+search_next(SearchIter* it, SearchMatch* match) {
+  SearchAutomaton* ac = it->ac;
+  const U8* h = (const U8*)it->haystack.cstr;
+  U64 size = it->haystack.size;
+  U32 row = it->row;
+  U64 at = it->at;
+
+  while(it->output == it->output_end) {
+    if(row == 0 && ac->skip) {
+      at = str8_find_byte_set(it->haystack, at, &ac->starts);
+    }
+    if(at >= size) {
+      it->at = size;
+      it->row = row;
+      return FALSE;
+    }
+    U32 next = ac->next[row + ac->classes[h[at]]];
+    at += 1;
+    row = next & SEARCH_ROW_MASK;
+    if(next & SEARCH_OUTPUT_FLAG) {
+      U32 state = row / ac->class_count;
+      it->output = ac->output_first[state];
+      it->output_end = ac->output_first[state + 1];
+    }
+  }
+
+  it->row = row;
+  it->at = at;
+  U32 pattern = ac->outputs[it->output++];
+  match->pattern = pattern;
+  match->offset = at - ac->pattern_sizes[pattern];
+  return TRUE;
+}
+
+MODULE U64
+search_count(SearchAutomaton* ac, Str8 haystack) {
+  const U8* h = (const U8*)haystack.cstr;
+  U64 size = haystack.size;
+  U64 result = 0;
+  U32 row = 0;
+  for(U64 at = 0; at < size; ++at) {
+    if(row == 0 && ac->skip) {
+      at = str8_find_byte_set(haystack, at, &ac->starts);
+      if(at >= size) {
+        break;
+      }
+    }
+    U32 next = ac->next[row + ac->classes[h[at]]];
+    row = next & SEARCH_ROW_MASK;
+    if(next & SEARCH_OUTPUT_FLAG) {
+      U32 state = row / ac->class_count;
+      result += ac->output_first[state + 1] - ac->output_first[state];
+    }
+  }
+  return result;
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_SEARCH_IMPLEMENTATION */
+#endif /* SEPI_SEARCH_H */
@@ -0,0 +1,673 @@
+#ifndef SEPI_UNICODE_H
+#define SEPI_UNICODE_H
+
+/* ===================================================== */
+/*                     DEPENDENCIES                      */
+/* ===================================================== */
+
+#include "base.h"
+#include "arena.h"
+#include "string.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* ===================================================== */
+/*                       CONSTANTS                       */
+/* ===================================================== */
+
+#if defined(SEPI_UNICODE_IMPLEMENTATION)
+#define MODULE
+#else
+#define MODULE static
+#endif /* SEPI_UNICODE_IMPLEMENTATION */
+
+#define UNICODE_REPLACEMENT 0xFFFD
+#define UNICODE_MAX 0x10FFFF
+#define UTF8_BLOCK 64
+
+/* ===================================================== */
+/*                         TYPES                         */
+/* ===================================================== */
+
+/* sizes count code units, not bytes or code points */
+typedef struct Str16 Str16;
+struct Str16 {
+  U16* str;
+  U64 size;
+};
+
+typedef struct Str32 Str32;
+struct Str32 {
+  U32* str;
+  U64 size;
+};
+
+/* `inc` is how many code units the code point took; malformed input
+   decodes to UNICODE_REPLACEMENT with `inc` 1 */
+typedef struct UnicodeDecode UnicodeDecode;
+struct UnicodeDecode {
+  U32 inc;
+  U32 codepoint;
+};
+
+/* ===================================================== */
+/*                          API                          */
+/* ===================================================== */
+
+MODULE UnicodeDecode utf8_decode(const U8* str, U64 max);
+MODULE UnicodeDecode utf16_decode(const U16* str, U64 max);
+MODULE U32 utf8_encode(U8* str, U32 codepoint);
+MODULE U32 utf16_encode(U16* str, U32 codepoint);
+MODULE Bool utf8_is_ascii(Str8 s);
+MODULE U64 utf8_valid_size(Str8 s);
+MODULE Bool utf8_validate(Str8 s);
+MODULE Str16 str16_from_8(Arena* a, Str8 in);
+MODULE Str32 str32_from_8(Arena* a, Str8 in);
+MODULE Str8 str8_from_16(Arena* a, Str16 in);
+MODULE Str8 str8_from_32(Arena* a, Str32 in);
+
+/* ===================================================== */
+/*                    IMPLEMENTATION                     */
+/* ===================================================== */
+
+#ifdef SEPI_UNICODE_IMPLEMENTATION
+
+/* strict: overlong forms, surrogates and anything past U+10FFFF are
+   rejected the same way the vector validator rejects them; `inc` is 0 for
+   malformed input */
+internal UnicodeDecode
+utf8_decode_strict(const U8* str, U64 max) {
+  UnicodeDecode result = {0};
+  U8 c = str[0];
+  U32 size = 0;
+  U32 codepoint = 0;
+  U32 min = 0;
+  if(c < 0x80) {
+    result.inc = 1;
+    result.codepoint = c;
+    return result;
+  } else if((c & 0xE0) == 0xC0) {
+    size = 2;
+    codepoint = c & 0x1F;
+    min = 0x80;
+  } else if((c & 0xF0) == 0xE0) {
+    size = 3;
+    codepoint = c & 0x0F;
+    min = 0x800;
+  } else if((c & 0xF8) == 0xF0) {
+    size = 4;
+    codepoint = c & 0x07;
+    min = 0x10000;
+  }
+  if(size == 0 || size > max) {
+    return result;
+  }
+  for(U32 i = 1; i < size; ++i) {
+    if((str[i] & 0xC0) != 0x80) {
+      return result;
+    }
+    codepoint = (codepoint << 6) | (str[i] & 0x3F);
+  }
+  if(codepoint >= min && codepoint <= UNICODE_MAX &&
+     (codepoint < 0xD800 || codepoint > 0xDFFF)) {
+    result.inc = size;
+    result.codepoint = codepoint;
+  }
+  return result;
+}
+
+MODULE UnicodeDecode
+utf8_decode(const U8* str, U64 max) {
+  UnicodeDecode result = utf8_decode_strict(str, max);
+  if(result.inc == 0) {
+    result.inc = 1;
+    result.codepoint = UNICODE_REPLACEMENT;
+  }
+  return result;
+}
+
+MODULE UnicodeDecode
+utf16_decode(const U16* str, U64 max) {
+  UnicodeDecode result = {1, str[0]};
+  U16 c = str[0];
+  if(0xD800 <= c && c <= 0xDFFF) {
+    result.codepoint = UNICODE_REPLACEMENT;
+    if(c < 0xDC00 && max > 1 && 0xDC00 <= str[1] && str[1] <= 0xDFFF) {
+      result.inc = 2;
+      result.codepoint = 0x10000 + (((U32)c - 0xD800) << 10) +
+                         ((U32)str[1] - 0xDC00);
+    }
+  }
+  return result;
+}
+
+/* code points that cannot be encoded (surrogates, past U+10FFFF) are
+   written as UNICODE_REPLACEMENT */
+MODULE U32
+utf8_encode(U8* str, U32 codepoint) {
+  if(codepoint > UNICODE_MAX || (0xD800 <= codepoint && codepoint <= 0xDFFF)) {
+    codepoint = UNICODE_REPLACEMENT;
+  }
+  U32 inc = 0;
+  if(codepoint < 0x80) {
+    str[0] = (U8)codepoint;
+    inc = 1;
+  } else if(codepoint < 0x800) {
+    str[0] = (U8)(0xC0 | (codepoint >> 6));
+    str[1] = (U8)(0x80 | (codepoint & 0x3F));
+    inc = 2;
+  } else if(codepoint < 0x10000) {
+    str[0] = (U8)(0xE0 | (codepoint >> 12));
+    str[1] = (U8)(0x80 | ((codepoint >> 6) & 0x3F));
+    str[2] = (U8)(0x80 | (codepoint & 0x3F));
+    inc = 3;
+  } else {
+    str[0] = (U8)(0xF0 | (codepoint >> 18));
+    str[1] = (U8)(0x80 | ((codepoint >> 12) & 0x3F));
+    str[2] = (U8)(0x80 | ((codepoint >> 6) & 0x3F));
+    str[3] = (U8)(0x80 | (codepoint & 0x3F));
+    inc = 4;
+  }
+  return inc;
+}
+
+MODULE U32
+utf16_encode(U16* str, U32 codepoint) {
+  if(codepoint > UNICODE_MAX || (0xD800 <= codepoint && codepoint <= 0xDFFF)) {
+    codepoint = UNICODE_REPLACEMENT;
+  }
+  U32 inc = 1;
+  if(codepoint < 0x10000) {
+    str[0] = (U16)codepoint;
+  } else {
+    codepoint -= 0x10000;
+    str[0] = (U16)(0xD800 + (codepoint >> 10));
+    str[1] = (U16)(0xDC00 + (codepoint & 0x3FF));
+    inc = 2;
+  }
+  return inc;
+}
+
+internal Bool
+utf8_is_ascii_16(const U8* p) {
+#if defined(__SSE2__)
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)) == 0;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  return vmaxvq_u8(vld1q_u8(p)) < 0x80;
+#else
+  U64 lo = 0;
+  U64 hi = 0;
+  MemoryCopy(&lo, p, sizeof(lo));
+  MemoryCopy(&hi, p + 8, sizeof(hi));
+  return ((lo | hi) & 0x8080808080808080ull) == 0;
+#endif /* __SSE2__ */
+}
+
+MODULE Bool
+utf8_is_ascii(Str8 s) {
+  const U8* p = (const U8*)s.cstr;
+  U64 i = 0;
+  U8 any = 0;
+  for(; i + 16 <= s.size; i += 16) {
+    if(!utf8_is_ascii_16(p + i)) {
+      return FALSE;
+    }
+  }
+  for(; i < s.size; ++i) {
+    any |= p[i];
+  }
+  return any < 0x80;
+}
+
+/* scalar walk from a character boundary, skipping ASCII 16 bytes at a
+   time; returns where the first malformed sequence starts */
+internal U64
+utf8_valid_size_from(const U8* p, U64 size, U64 at) {
+  while(at < size) {
+    if(at + 16 <= size && utf8_is_ascii_16(p + at)) {
+      at += 16;
+      continue;
+    }
+    UnicodeDecode d = utf8_decode_strict(p + at, size - at);
+    if(d.inc == 0) {
+      break;
+    }
+    at += d.inc;
+  }
+  return at;
+}
+
+/* the lookup validator of Keiser & Lemire ("Validating UTF-8 in less than
+   one instruction per byte"): three 16-entry tables indexed by the high
+   nibble of the previous byte, its low nibble and the high nibble of the
+   current byte flag every malformed two-byte pattern; the 3 and 4 byte
+   lengths are checked from the bytes two and three back */
+#define UTF8_TOO_SHORT (1 << 0)
+#define UTF8_TOO_LONG (1 << 1)
+#define UTF8_OVERLONG_3 (1 << 2)
+#define UTF8_TOO_LARGE (1 << 3)
+#define UTF8_SURROGATE (1 << 4)
+#define UTF8_OVERLONG_2 (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4 (1 << 6)
+#define UTF8_TWO_CONTS (1 << 7)
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+internal const U8 utf8_byte_1_high[16] = {
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+  UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+  UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+  UTF8_TOO_SHORT,
+  UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+  UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+internal const U8 utf8_byte_1_low[16] = {
+  UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+  UTF8_CARRY | UTF8_OVERLONG_2,
+  UTF8_CARRY,
+  UTF8_CARRY,
+  UTF8_CARRY | UTF8_TOO_LARGE,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+internal const U8 utf8_byte_2_high[16] = {
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+  UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+  UTF8_TOO_LARGE,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+  UTF8_TOO_LARGE,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+  UTF8_TOO_LARGE,
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+};
+
+/* the last three bytes of a block may still be waiting for continuations:
+   anything above these limits there is an unfinished lead byte */
+internal const U8 utf8_incomplete_max[32] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+#if defined(__AVX2__)
+
+typedef struct Utf8State Utf8State;
+struct Utf8State {
+  __m256i error;
+  __m256i previous;
+  __m256i incomplete;
+};
+
+internal __m256i
+utf8_lookup_32(const U8* table, __m256i index) {
+  __m256i t = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table));
+  return _mm256_shuffle_epi8(t, index);
+}
+
+internal Nothing
+utf8_check_32(Utf8State* st, __m256i input) {
+  __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  __m256i carried = _mm256_permute2x128_si256(st->previous, input, 0x21);
+  __m256i prev1 = _mm256_alignr_epi8(input, carried, 16 - 1);
+  __m256i prev2 = _mm256_alignr_epi8(input, carried, 16 - 2);
+  __m256i prev3 = _mm256_alignr_epi8(input, carried, 16 - 3);
+
+  __m256i b1h = utf8_lookup_32(utf8_byte_1_high,
+                               _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+  __m256i b1l = utf8_lookup_32(utf8_byte_1_low, _mm256_and_si256(prev1, low_nibble));
+  __m256i b2h = utf8_lookup_32(utf8_byte_2_high,
+                               _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+  __m256i special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+
+  __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((I8)(0xE0 - 0x80)));
+  __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((I8)(0xF0 - 0x80)));
+  __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                    _mm256_set1_epi8((I8)0x80));
+  st->error = _mm256_or_si256(st->error, _mm256_xor_si256(must23, special));
+  st->previous = input;
+}
+
+internal Nothing
+utf8_check_block(Utf8State* st, const U8* p) {
+  __m256i a = _mm256_loadu_si256((const __m256i*)p);
+  __m256i b = _mm256_loadu_si256((const __m256i*)(p + 32));
+  if(_mm256_movemask_epi8(_mm256_or_si256(a, b)) == 0) {
+    st->error = _mm256_or_si256(st->error, st->incomplete);
+  } else {
+    utf8_check_32(st, a);
+    utf8_check_32(st, b);
+    __m256i max = _mm256_loadu_si256((const __m256i*)utf8_incomplete_max);
+    st->incomplete = _mm256_subs_epu8(b, max);
+  }
+}
+
+internal Bool
+utf8_state_ok(Utf8State* st, Bool end) {
+  __m256i error = st->error;
+  if(end) {
+    error = _mm256_or_si256(error, st->incomplete);
+  }
+  return _mm256_testz_si256(error, error);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+typedef struct Utf8State Utf8State;
+struct Utf8State {
+  uint8x16_t error;
+  uint8x16_t previous;
+  uint8x16_t incomplete;
+};
+
+internal Nothing
+utf8_check_16(Utf8State* st, uint8x16_t input) {
+  uint8x16_t prev1 = vextq_u8(st->previous, input, 16 - 1);
+  uint8x16_t prev2 = vextq_u8(st->previous, input, 16 - 2);
+  uint8x16_t prev3 = vextq_u8(st->previous, input, 16 - 3);
+  uint8x16_t b1h = vqtbl1q_u8(vld1q_u8(utf8_byte_1_high), vshrq_n_u8(prev1, 4));
+  uint8x16_t b1l = vqtbl1q_u8(vld1q_u8(utf8_byte_1_low),
+                              vandq_u8(prev1, vdupq_n_u8(0x0F)));
+  uint8x16_t b2h = vqtbl1q_u8(vld1q_u8(utf8_byte_2_high), vshrq_n_u8(input, 4));
+  uint8x16_t special = vandq_u8(vandq_u8(b1h, b1l), b2h);
+
+  uint8x16_t third = vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80));
+  uint8x16_t fourth = vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80));
+  uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+  st->error = vorrq_u8(st->error, veorq_u8(must23, special));
+  st->previous = input;
+}
+
+internal Nothing
+utf8_check_block(Utf8State* st, const U8* p) {
+  uint8x16_t a = vld1q_u8(p);
+  uint8x16_t b = vld1q_u8(p + 16);
+  uint8x16_t c = vld1q_u8(p + 32);
+  uint8x16_t d = vld1q_u8(p + 48);
+  if(vmaxvq_u8(vorrq_u8(vorrq_u8(a, b), vorrq_u8(c, d))) < 0x80) {
+    st->error = vorrq_u8(st->error, st->incomplete);
+  } else {
+    utf8_check_16(st, a);
+    utf8_check_16(st, b);
+    utf8_check_16(st, c);
+    utf8_check_16(st, d);
+    st->incomplete = vqsubq_u8(d, vld1q_u8(utf8_incomplete_max + 16));
+  }
+}
+
+internal Bool
+utf8_state_ok(Utf8State* st, Bool end) {
+  uint8x16_t error = st->error;
+  if(end) {
+    error = vorrq_u8(error, st->incomplete);
+  }
+  return vmaxvq_u8(error) == 0;
+}
+
+#endif /* __AVX2__ */
+
+#if defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+
+/* where the scalar walk can restart for a block the vector check flagged:
+   everything before `at` is known good, so a lead byte in the last three
+   bytes is a boundary, and three continuations close a four byte char */
+internal U64
+utf8_block_boundary(const U8* p, U64 at) {
+  for(U64 k = 1; k <= 3 && k <= at; ++k) {
+    U8 c = p[at - k];
+    if((c & 0xC0) != 0x80) {
+      return c >= 0xC0 ? at - k : at;
+    }
+  }
+  return at;
+}
+
+#endif /* __AVX2__ || __aarch64__ */
+
+/* length of the longest valid prefix, s.size when all of it is valid */
+MODULE U64
+utf8_valid_size(Str8 s) {
+  const U8* p = (const U8*)s.cstr;
+  U64 at = 0;
+#if defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  Utf8State st;
+  MemZeroStruct(&st);
+  for(; at + UTF8_BLOCK <= s.size; at += UTF8_BLOCK) {
+    utf8_check_block(&st, p + at);
+    if(!utf8_state_ok(&st, FALSE)) {
+      return utf8_valid_size_from(p, s.size, utf8_block_boundary(p, at));
+    }
+  }
+  at = utf8_block_boundary(p, at);
+#endif /* __AVX2__ || __aarch64__ */
+  return utf8_valid_size_from(p, s.size, at);
+}
+
+MODULE Bool
+utf8_validate(Str8 s) {
+  const U8* p = (const U8*)s.cstr;
+#if defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  Utf8State st;
+  MemZeroStruct(&st);
+  U64 at = 0;
+  for(; at + UTF8_BLOCK <= s.size; at += UTF8_BLOCK) {
+    utf8_check_block(&st, p + at);
+  }
+  if(at < s.size) {
+    U8 tail[UTF8_BLOCK];
+    MemZeroArray(tail);
+    MemoryCopy(tail, p + at, s.size - at);
+    utf8_check_block(&st, tail);
+  }
+  return utf8_state_ok(&st, TRUE);
+#else
+  return utf8_valid_size_from(p, s.size, 0) == s.size;
+#endif /* __AVX2__ || __aarch64__ */
+}
+
+/* decode for input utf8_validate already accepted, no checks left */
+internal FORCE_INLINE UnicodeDecode
+utf8_decode_valid(const U8* p) {
+  UnicodeDecode result = {1, p[0]};
+  U32 c = p[0];
+  if(c >= 0xF0) {
+    result.inc = 4;
+    result.codepoint = ((c & 0x07) << 18) | ((U32)(p[1] & 0x3F) << 12) |
+                       ((U32)(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+  } else if(c >= 0xE0) {
+    result.inc = 3;
+    result.codepoint = ((c & 0x0F) << 12) | ((U32)(p[1] & 0x3F) << 6) |
+                       (p[2] & 0x3F);
+  } else if(c >= 0xC0) {
+    result.inc = 2;
+    result.codepoint = ((c & 0x1F) << 6) | (p[1] & 0x3F);
+  }
+  return result;
+}
+
+/* ASCII runs are widened 16 bytes at a time, everything else decodes one
+   code point at a time; input that passes utf8_validate (the common case,
+   checked at vector speed up front) skips the per-sequence checks, and
+   malformed bytes elsewhere become UNICODE_REPLACEMENT */
+internal Nothing
+utf8_widen_16(U16* out, const U8* p) {
+#if defined(__SSE2__)
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i zero = _mm_setzero_si128();
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(v, zero));
+  _mm_storeu_si128((__m128i*)(out + 8), _mm_unpackhi_epi8(v, zero));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  uint8x16_t v = vld1q_u8(p);
+  vst1q_u16(out, vmovl_u8(vget_low_u8(v)));
+  vst1q_u16(out + 8, vmovl_high_u8(v));
+#else
+  for(U64 i = 0; i < 16; ++i) {
+    out[i] = p[i];
+  }
+#endif /* __SSE2__ */
+}
+
+internal Nothing
+utf8_widen_32(U32* out, const U8* p) {
+#if defined(__SSE2__)
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_unpacklo_epi8(v, zero);
+  __m128i hi = _mm_unpackhi_epi8(v, zero);
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(lo, zero));
+  _mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi16(lo, zero));
+  _mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi16(hi, zero));
+  _mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(hi, zero));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  uint8x16_t v = vld1q_u8(p);
+  uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+  uint16x8_t hi = vmovl_high_u8(v);
+  vst1q_u32(out, vmovl_u16(vget_low_u16(lo)));
+  vst1q_u32(out + 4, vmovl_high_u16(lo));
+  vst1q_u32(out + 8, vmovl_u16(vget_low_u16(hi)));
+  vst1q_u32(out + 12, vmovl_high_u16(hi));
+#else
+  for(U64 i = 0; i < 16; ++i) {
+    out[i] = p[i];
+  }
+#endif /* __SSE2__ */
+}
+
+/* outputs are sized for the worst case and the unused tail is handed back
+   to the arena; every result ends in a zero code unit not counted in size */
+MODULE Str16
+str16_from_8(Arena* a, Str8 in) {
+  const U8* p = (const U8*)in.cstr;
+  U16* out = arena_push_array_no_zero(a, U16, in.size + 1);
+  Bool valid = utf8_validate(in);
+  U64 size = 0;
+  for(U64 i = 0; i < in.size;) {
+    if(p[i] < 0x80 && i + 16 <= in.size && utf8_is_ascii_16(p + i)) {
+      utf8_widen_16(out + size, p + i);
+      size += 16;
+      i += 16;
+      continue;
+    }
+    UnicodeDecode d = valid ? utf8_decode_valid(p + i) :
+                      utf8_decode(p + i, in.size - i);
+    size += utf16_encode(out + size, d.codepoint);
+    i += d.inc;
+  }
+  out[size] = 0;
+  arena_pop(a, (in.size - size) * sizeof(U16));
+  Str16 result = {out, size};
+  return result;
+}
+
+MODULE Str32
+str32_from_8(Arena* a, Str8 in) {
+  const U8* p = (const U8*)in.cstr;
+  U32* out = arena_push_array_no_zero(a, U32, in.size + 1);
+  Bool valid = utf8_validate(in);
+  U64 size = 0;
+  for(U64 i = 0; i < in.size;) {
+    if(p[i] < 0x80 && i + 16 <= in.size && utf8_is_ascii_16(p + i)) {
+      utf8_widen_32(out + size, p + i);
+      size += 16;
+      i += 16;
+      continue;
+    }
+    UnicodeDecode d = valid ? utf8_decode_valid(p + i) :
+                      utf8_decode(p + i, in.size - i);
+    out[size++] = d.codepoint;
+    i += d.inc;
+  }
+  out[size] = 0;
+  arena_pop(a, (in.size - size) * sizeof(U32));
+  Str32 result = {out, size};
+  return result;
+}
+
+internal Bool
+utf16_narrow_8(U8* out, const U16* p) {
+#if defined(__SSE2__)
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i high = _mm_and_si128(v, _mm_set1_epi16((I16)0xFF80));
+  if(_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF) {
+    return FALSE;
+  }
+  _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(v, v));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  uint16x8_t v = vld1q_u16(p);
+  if(vmaxvq_u16(v) >= 0x80) {
+    return FALSE;
+  }
+  vst1_u8(out, vmovn_u16(v));
+#else
+  for(U64 i = 0; i < 8; ++i) {
+    if(p[i] >= 0x80) {
+      return FALSE;
+    }
+  }
+  for(U64 i = 0; i < 8; ++i) {
+    out[i] = (U8)p[i];
+  }
+#endif /* __SSE2__ */
+  return TRUE;
+}
+
+MODULE Str8
+str8_from_16(Arena* a, Str16 in) {
+  U64 capacity = in.size * 3;
+  U8* out = arena_push_array_no_zero(a, U8, capacity + 1);
+  U64 size = 0;
+  for(U64 i = 0; i < in.size;) {
+    if(i + 8 <= in.size && utf16_narrow_8(out + size, in.str + i)) {
+      size += 8;
+      i += 8;
+      continue;
+    }
+    UnicodeDecode d = utf16_decode(in.str + i, in.size - i);
+    size += utf8_encode(out + size, d.codepoint);
+    i += d.inc;
+  }
+  out[size] = 0;
+  arena_pop(a, capacity - size);
+  return str8_raw(out, size);
+}
+
+MODULE Str8
+str8_from_32(Arena* a, Str32 in) {
+  U64 capacity = in.size * 4;
+  U8* out = arena_push_array_no_zero(a, U8, capacity + 1);
+  U64 size = 0;
+  for(U64 i = 0; i < in.size; ++i) {
+    size += utf8_encode(out + size, in.str[i]);
+  }
+  out[size] = 0;
+  arena_pop(a, capacity - size);
+  return str8_raw(out, size);
+}
+
+/* ===================================================== */
+/*                          END                          */
+/* ===================================================== */
+
+#endif /* SEPI_UNICODE_IMPLEMENTATION */
+#endif /* SEPI_UNICODE_H */